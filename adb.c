@@ -0,0 +1,381 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/irq.h"
+#include "adb.h"
+#include "adb.pio.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+#define ADB_NONE         0xFF
+#define ADB_RELEASE      0x80
+#define ADB_CAPS         0x39
+#define ADB_RESET_MARK   0xFFFFFFFF
+
+#define ADB_FLUSH        0x01
+#define ADB_LISTEN       0x02
+#define ADB_TALK         0x03
+
+extern bool debug;
+
+typedef struct {
+  uint8_t            default_address;
+  uint8_t            default_handler;
+  uint16_t           handlers;           // bit n set: handler id n supported
+  volatile uint8_t   address;
+  volatile uint8_t   handler;
+  volatile bool      srq_enable;
+  volatile bool      collision;          // the last Talk R3 answer was overwritten
+  volatile bool      changed;            // register 3 must be rebuilt
+  volatile bool      reset;              // pending data must be dropped
+  uint32_t           slot[2];            // register 0 answers, built by the main loop
+  volatile uint32_t *volatile live;      // the one the interrupt answers from, 0 = nothing
+  volatile uint32_t  r2;
+  volatile uint32_t  r3;
+} AdbDevice;
+
+// USB HID usage to ADB key code (Apple Extended Keyboard)
+static const uint8_t to_adb[0x65] = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x0B, 0x08, 0x02,   /* 0x00 */
+  0x0E, 0x03, 0x05, 0x04, 0x22, 0x26, 0x28, 0x25,   /* 0x08 */
+  0x2E, 0x2D, 0x1F, 0x23, 0x0C, 0x0F, 0x01, 0x11,   /* 0x10 */
+  0x20, 0x09, 0x0D, 0x07, 0x10, 0x06, 0x12, 0x13,   /* 0x18 */
+  0x14, 0x15, 0x17, 0x16, 0x1A, 0x1C, 0x19, 0x1D,   /* 0x20 */
+  0x24, 0x35, 0x33, 0x30, 0x31, 0x1B, 0x18, 0x21,   /* 0x28 */
+  0x1E, 0x2A, 0x2A, 0x29, 0x27, 0x32, 0x2B, 0x2F,   /* 0x30 */
+  0x2C, 0x39, 0x7A, 0x78, 0x63, 0x76, 0x60, 0x61,   /* 0x38 */
+  0x62, 0x64, 0x65, 0x6D, 0x67, 0x6F, 0x69, 0x6B,   /* 0x40 PRTSCR SCRLCK = F13 F14 */
+  0x71, 0x72, 0x73, 0x74, 0x75, 0x77, 0x79, 0x3C,   /* 0x48 PAUSE = F15, INSERT = HELP */
+  0x3B, 0x3D, 0x3E, 0x47, 0x4B, 0x43, 0x4E, 0x45,   /* 0x50 NUMLOCK = CLEAR */
+  0x4C, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,   /* 0x58 */
+  0x5B, 0x5C, 0x52, 0x41, 0x0A                      /* 0x60 */
+};
+
+// left and right modifiers, handler 2 sends the left codes for both
+static const uint8_t mod_adb[8] = { 0x36, 0x38, 0x3A, 0x37, 0x7D, 0x7B, 0x7C, 0x37 };
+
+static uint offset, sniff_offset;
+
+static AdbDevice kbd   = { ADB_KBD_ADDRESS,   ADB_KBD_HANDLER,   0x000E };
+static AdbDevice mouse = { ADB_MOUSE_ADDRESS, ADB_MOUSE_HANDLER, 0x0006 };
+static AdbDevice *const devices[2] = { &kbd, &mouse };
+
+static uint8_t  queue[ADB_QUEUE_SIZE];
+static int      head, tail, size;
+static uint8_t  mods;
+static bool     caps;
+static bool     del;
+static volatile uint8_t leds = 0x07;     // register 2 bits 2..0, active low
+static volatile bool    leds_changed;
+static int32_t  acc_x, acc_y;
+static bool     left, right;
+static bool     last_left, last_right;
+static uint32_t seed;
+
+// interrupt side: what the sniffer is collecting for
+static AdbDevice *target;
+static uint8_t    target_cmd;
+static uint16_t   target_r3;          // the R3 data of the Talk answer on the bus
+static int        nbits;
+static uint32_t   bits;
+
+// start bit, 16 bits, stop bit, inverted for the state machine
+HOTSPOT static uint32_t adb_frame(uint16_t data) {
+  uint32_t cells = (1u << 17) | ((uint32_t) data << 1);
+
+  return (18u << 26) | ((~cells & 0x3FFFF) << 8);
+}
+
+static void __not_in_flash_func(sniff)(bool on) {
+  pio_sm_set_enabled(ADB_PIO, ADB_SNIFF_SM, false);
+  if (!on)
+    return;
+  pio_sm_clear_fifos(ADB_PIO, ADB_SNIFF_SM);
+  pio_sm_restart(ADB_PIO, ADB_SNIFF_SM);
+  pio_sm_exec(ADB_PIO, ADB_SNIFF_SM, pio_encode_jmp(sniff_offset));
+  pio_sm_set_enabled(ADB_PIO, ADB_SNIFF_SM, true);
+  nbits = 0;
+  bits  = 0;
+}
+
+static void __not_in_flash_func(device_reset)(AdbDevice *dev) {
+  dev->address    = dev->default_address;
+  dev->handler    = dev->default_handler;
+  dev->srq_enable = true;
+  dev->collision  = false;
+  dev->slot[0]    = 0;
+  dev->slot[1]    = 0;
+  dev->changed    = true;
+  dev->reset      = true;
+}
+
+static void __not_in_flash_func(listen_r3)(AdbDevice *dev, uint16_t data) {
+  uint8_t address = (data >> 8) & 0x0F;
+  uint8_t handler = data & 0xFF;
+
+  switch (handler) {
+  case 0x00:
+    dev->address    = address;
+    dev->srq_enable = (data & 0x2000) ? true : false;
+    break;
+  case 0xFE:
+    // address resolution: only the device that was not overwritten moves
+    if (!dev->collision)
+      dev->address = address;
+    break;
+  case 0xFD:
+  case 0xFF:
+    break;
+  default:
+    if ((handler < 16) && (dev->handlers & (1 << handler)))
+      dev->handler = handler;
+    break;
+  }
+  dev->collision = false;
+  dev->changed   = true;
+}
+
+// cells of a Talk answer or a Listen: the command stop bit, the start
+// bit, 16 data bits
+static void __not_in_flash_func(sniffed)(uint32_t bit) {
+  uint16_t data;
+
+  bits = (bits << 1) | (bit & 1);
+  if (++nbits < 18)
+    return;
+  sniff(false);
+  data = bits & 0xFFFF;
+  if (!target || !(bits & 0x10000))
+    return;
+  if ((target_cmd >> 2) == ADB_TALK)
+    target->collision = (data != target_r3);
+  else if ((target_cmd & 0x03) == 3)
+    listen_r3(target, data);
+  else if (((target_cmd & 0x03) == 2) && (target == &kbd)) {
+    leds = data & 0x07;
+    leds_changed = true;
+  }
+  target = NULL;
+}
+
+// a command byte: everything needed for the answer is ready in the
+// device slots, this only picks the right word
+static void __not_in_flash_func(command)(uint32_t v) {
+  AdbDevice *dev = NULL;
+  uint32_t answer = 0;
+  uint8_t cmd = v & 0xFF;
+  int i;
+
+  target = NULL;
+  sniff(false);
+  if (v == ADB_RESET_MARK) {
+    device_reset(&kbd);
+    device_reset(&mouse);
+    return;
+  }
+  for (i = 0; i < 2; i++)
+    if (devices[i]->address == (cmd >> 4))
+      dev = devices[i];
+  if ((cmd & 0x0F) == 0) {
+    // SendReset, whoever it is addressed to
+    device_reset(&kbd);
+    device_reset(&mouse);
+    dev = NULL;
+  } else if (dev) {
+    switch ((cmd >> 2) & 0x03) {
+    case 0:
+      if ((cmd & 0x03) == ADB_FLUSH) {
+	*dev->live = 0;
+	dev->reset = true;
+      }
+      break;
+    case ADB_LISTEN:
+      if (((cmd & 0x03) == 3) || (((cmd & 0x03) == 2) && (dev == &kbd))) {
+	target     = dev;
+	target_cmd = cmd;
+	sniff(true);
+      }
+      break;
+    case ADB_TALK:
+      switch (cmd & 0x03) {
+      case 0:
+	if ((answer = *dev->live))
+	  *dev->live = 0;
+	break;
+      case 2:
+	if (dev == &kbd)
+	  answer = dev->r2;
+	break;
+      case 3:
+	answer       = dev->r3;
+	dev->changed = true;             // next answer gets a new random address
+	// taken from the word itself: adb_task() rebuilds r3 while
+	// this one is still on the bus
+	target_r3    = ~(answer >> 9) & 0xFFFF;
+	target       = dev;
+	target_cmd   = cmd;
+	sniff(true);
+	break;
+      }
+      break;
+    }
+  }
+  for (i = 0; i < 2; i++)
+    if ((devices[i] != dev) && devices[i]->srq_enable && *devices[i]->live)
+      answer |= 0x80000000;
+  pio_sm_put(ADB_PIO, ADB_SM, answer);
+}
+
+static void __not_in_flash_func(adb_irq)(void) {
+  while (!pio_sm_is_rx_fifo_empty(ADB_PIO, ADB_SM))
+    command(pio_sm_get(ADB_PIO, ADB_SM));
+  while (!pio_sm_is_rx_fifo_empty(ADB_PIO, ADB_SNIFF_SM))
+    sniffed(pio_sm_get(ADB_PIO, ADB_SNIFF_SM));
+}
+
+// hand a register 0 answer over: written to the spare slot, then swapped in
+static void publish(AdbDevice *dev, uint16_t data) {
+  uint32_t *spare = (dev->live == &dev->slot[0]) ? &dev->slot[1] : &dev->slot[0];
+
+  *spare    = adb_frame(data);
+  dev->live = spare;
+}
+
+static void update_r2(void) {
+  uint16_t r2 = 0xFFF8 | leds;
+
+  if (del)
+    r2 &= ~0x4000;
+  if (caps)
+    r2 &= ~0x2000;
+  if (mods & 0x11)
+    r2 &= ~0x0800;
+  if (mods & 0x22)
+    r2 &= ~0x0400;
+  if (mods & 0x44)
+    r2 &= ~0x0200;
+  if (mods & 0x88)
+    r2 &= ~0x0100;
+  kbd.r2 = adb_frame(r2);
+}
+
+static void update_r3(AdbDevice *dev) {
+  uint16_t data;
+
+  seed = seed * 1103515245 + 12345 + time_us_32();
+  data = (dev->srq_enable ? 0x2000 : 0) | (((seed >> 16) & 0x0F) << 8) | dev->handler;
+  dev->r3 = adb_frame(data);
+}
+
+void adb_key_event(uint8_t keycode, bool pressed) {
+  uint8_t code = ADB_NONE;
+
+  if (keycode >= 0xE0) {
+    uint8_t i = keycode & 0x07;
+    uint8_t bit = 1 << i;
+
+    mods = pressed ? (mods | bit) : (mods & ~bit);
+    code = mod_adb[(kbd.handler == 3) ? i : (i & 0x03)];
+    // the same code on both sides is only sent for the first down / last up
+    if ((code == mod_adb[i ^ 0x04]) || (kbd.handler != 3))
+      if (mods & (1 << (i ^ 0x04)))
+	code = ADB_NONE;
+  } else if (keycode == 0x39) {
+    // Caps Lock is a locking key on ADB
+    if (pressed) {
+      caps = !caps;
+      code = caps ? ADB_CAPS : ADB_CAPS | ADB_RELEASE;
+    }
+  } else if (keycode < sizeof(to_adb))
+    code = to_adb[keycode];
+  if (keycode == 0x2A)
+    del = pressed;
+  update_r2();
+  if (code == ADB_NONE)
+    return;
+  if (size == ADB_QUEUE_SIZE) {
+    if (debug)
+      printf("adb keyboard queue full\n");
+    return;
+  }
+  queue[tail] = pressed ? code : code | ADB_RELEASE;
+  tail = (tail + 1) % ADB_QUEUE_SIZE;
+  size++;
+}
+
+void adb_mouse(int16_t dx, int16_t dy, bool l, bool r) {
+  acc_x += dx;
+  acc_y += dy;
+  left   = l;
+  right  = r;
+}
+
+void adb_init(void) {
+  pio_sm_claim(ADB_PIO, ADB_SM);
+  pio_sm_claim(ADB_PIO, ADB_SNIFF_SM);
+  offset       = pio_add_program(ADB_PIO, &adb_program);
+  sniff_offset = pio_add_program(ADB_PIO, &adb_sniff_program);
+  adb_sniff_program_init(ADB_PIO, ADB_SNIFF_SM, sniff_offset, ADB_PIN);
+  seed = time_us_32();
+  kbd.live   = &kbd.slot[0];
+  mouse.live = &mouse.slot[0];
+  device_reset(&kbd);
+  device_reset(&mouse);
+  update_r2();
+  update_r3(&kbd);
+  update_r3(&mouse);
+  irq_set_exclusive_handler(PIO0_IRQ_0, adb_irq);
+  pio_set_irq0_source_enabled(ADB_PIO, pis_sm0_rx_fifo_not_empty, true);
+  pio_set_irq0_source_enabled(ADB_PIO, pis_sm1_rx_fifo_not_empty, true);
+  irq_set_enabled(PIO0_IRQ_0, true);
+  adb_program_init(ADB_PIO, ADB_SM, offset, ADB_PIN);
+}
+
+// main loop side: refill the register 0 slot the host has taken, the
+// service request goes up by itself as soon as a slot is live
+void adb_task(void) {
+  int i;
+
+  if (kbd.reset) {
+    kbd.reset = false;
+    head = tail = size = 0;
+  }
+  if (mouse.reset) {
+    mouse.reset = false;
+    acc_x = acc_y = 0;
+    last_left  = left;
+    last_right = right;
+  }
+  if (!*kbd.live && size) {
+    uint16_t data = queue[head] << 8;
+
+    head = (head + 1) % ADB_QUEUE_SIZE;
+    size--;
+    if (size) {
+      data |= queue[head];
+      head = (head + 1) % ADB_QUEUE_SIZE;
+      size--;
+    } else
+      data |= ADB_NONE;
+    publish(&kbd, data);
+  }
+  if (!*mouse.live && (acc_x || acc_y || (left != last_left) || (right != last_right))) {
+    int32_t dx = (acc_x < -64) ? -64 : (acc_x > 63) ? 63 : acc_x;
+    int32_t dy = (acc_y < -64) ? -64 : (acc_y > 63) ? 63 : acc_y;
+
+    acc_x -= dx;
+    acc_y -= dy;
+    last_left  = left;
+    last_right = right;
+    publish(&mouse, (left ? 0 : 0x8000) | ((dy & 0x7F) << 8) | (right ? 0 : 0x80) | (dx & 0x7F));
+  }
+  if (leds_changed) {
+    leds_changed = false;
+    update_r2();
+  }
+  for (i = 0; i < 2; i++)
+    if (devices[i]->changed) {
+      devices[i]->changed = false;
+      update_r3(devices[i]);
+    }
+}
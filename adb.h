@@ -0,0 +1,20 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/pio.h"
+
+#define ADB_PIO            pio0
+#define ADB_SM             0
+#define ADB_SNIFF_SM       1
+#define ADB_PIN            2
+
+#define ADB_KBD_ADDRESS    2
+#define ADB_KBD_HANDLER    2          // 3 = left / right modifiers apart
+#define ADB_MOUSE_ADDRESS  3
+#define ADB_MOUSE_HANDLER  1
+
+#define ADB_QUEUE_SIZE     16
+
+void adb_init(void);
+void adb_key_event(uint8_t, bool);
+void adb_mouse(int16_t, int16_t, bool, bool);
+void adb_task(void);
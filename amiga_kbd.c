@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "amiga_kbd.h"
+#include "amiga_kbd.pio.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+#define AMIGA_NONE          0xFF
+#define AMIGA_RESET_WARNING 0x78
+#define AMIGA_LOST_SYNC     0xF9
+#define AMIGA_OVERFLOW      0xFA
+#define AMIGA_POWERUP_START 0xFD
+#define AMIGA_POWERUP_END   0xFE
+#define AMIGA_CTRL          0x63
+#define AMIGA_CAPS          0x62
+#define AMIGA_RELEASE       0x80
+
+#define AMIGA_IDLE          0
+#define AMIGA_BUSY          1         // byte sent, waiting for the handshake
+#define AMIGA_SYNC          2         // clocking 1 bits until the Amiga answers
+#define AMIGA_WARN1         3
+#define AMIGA_WARN2         4
+#define AMIGA_HOLD          5         // KCLK low, the Amiga is being reset
+
+extern bool debug;
+
+// USB HID usage to Amiga raw key code
+static const uint8_t to_amiga[0x65] = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0x20, 0x35, 0x33, 0x22,   /* 0x00 */
+  0x12, 0x23, 0x24, 0x25, 0x17, 0x26, 0x27, 0x28,   /* 0x08 */
+  0x37, 0x36, 0x18, 0x19, 0x10, 0x13, 0x21, 0x14,   /* 0x10 */
+  0x16, 0x34, 0x11, 0x32, 0x15, 0x31, 0x01, 0x02,   /* 0x18 */
+  0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A,   /* 0x20 */
+  0x44, 0x45, 0x41, 0x42, 0x40, 0x0B, 0x0C, 0x1A,   /* 0x28 */
+  0x1B, 0x0D, 0x2B, 0x29, 0x2A, 0x00, 0x38, 0x39,   /* 0x30 */
+  0x3A, 0x62, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55,   /* 0x38 */
+  0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0xFF, 0xFF,   /* 0x40 F11 F12 = keypad ( ) */
+  0xFF, 0xFF, 0xFF, 0x5F, 0x46, 0xFF, 0xFF, 0x4E,   /* 0x48 PGUP = HELP */
+  0x4F, 0x4D, 0x4C, 0xFF, 0x5C, 0x5D, 0x4A, 0x5E,   /* 0x50 */
+  0x43, 0x1D, 0x1E, 0x1F, 0x2D, 0x2E, 0x2F, 0x3D,   /* 0x58 */
+  0x3E, 0x3F, 0x0F, 0x3C, 0x30                      /* 0x60 */
+};
+
+static const uint8_t mod_amiga[8] = { 0x63, 0x60, 0x64, 0x66, 0x63, 0x61, 0x65, 0x67 };
+
+static uint     offset;
+static uint8_t  queue[AMIGA_QUEUE_SIZE];
+static int      head, tail, size;
+static bool     overflow;           // overflow code queued, drop until drained
+static uint8_t  state;
+static uint64_t deadline;
+static uint8_t  current;            // byte waiting for its handshake
+static bool     lost;               // resend current once back in sync
+static bool     powerup;            // send the power-up key stream once in sync
+static bool     caps;
+static uint8_t  mods;
+
+// the Amiga reads 6-5-4-3-2-1-0-7, the release bit last
+HOTSPOT static uint32_t amiga_frame(uint8_t code) {
+  uint8_t wire = (code << 1) | (code >> 7);
+
+  return (7u << 28) | ((uint32_t) wire << 20);
+}
+
+static void restart(void) {
+  pio_sm_set_enabled(AMIGA_KBD_PIO, AMIGA_KBD_SM, false);
+  pio_sm_clear_fifos(AMIGA_KBD_PIO, AMIGA_KBD_SM);
+  pio_sm_restart(AMIGA_KBD_PIO, AMIGA_KBD_SM);
+  pio_sm_set_pindirs_with_mask(AMIGA_KBD_PIO, AMIGA_KBD_SM, 0, 3u << AMIGA_KBD_DAT_PIN);
+  pio_sm_exec(AMIGA_KBD_PIO, AMIGA_KBD_SM, pio_encode_jmp(offset));
+  pio_sm_set_enabled(AMIGA_KBD_PIO, AMIGA_KBD_SM, true);
+}
+
+// the last three slots are kept for the overflow, lost sync and resent codes
+static void queue_code(uint8_t code) {
+  if (overflow)
+    return;
+  if (size >= AMIGA_QUEUE_SIZE - 3) {
+    code     = AMIGA_OVERFLOW;
+    overflow = true;
+    if (debug)
+      printf("amiga keyboard overflow\n");
+  }
+  queue[tail] = code;
+  tail = (tail + 1) % AMIGA_QUEUE_SIZE;
+  size++;
+}
+
+static void queue_front(uint8_t code) {
+  if (size == AMIGA_QUEUE_SIZE)
+    return;
+  head = (head + AMIGA_QUEUE_SIZE - 1) % AMIGA_QUEUE_SIZE;
+  queue[head] = code;
+  size++;
+}
+
+static void flush(void) {
+  head = tail = size = 0;
+  overflow = false;
+}
+
+static void send(uint8_t code, uint8_t next, uint64_t timeout) {
+  current  = code;
+  state    = next;
+  deadline = time_us_64() + timeout;
+  pio_sm_put(AMIGA_KBD_PIO, AMIGA_KBD_SM, amiga_frame(code));
+}
+
+// clock out a single 1 bit and wait for the handshake
+static void sync(void) {
+  restart();
+  state    = AMIGA_SYNC;
+  deadline = time_us_64() + AMIGA_HANDSHAKE_US;
+  pio_sm_put(AMIGA_KBD_PIO, AMIGA_KBD_SM, 1u << 27);
+}
+
+static void hard_reset(void) {
+  if (debug)
+    printf("amiga hard reset\n");
+  pio_sm_set_enabled(AMIGA_KBD_PIO, AMIGA_KBD_SM, false);
+  pio_sm_set_pindirs_with_mask(AMIGA_KBD_PIO, AMIGA_KBD_SM, 2u << AMIGA_KBD_DAT_PIN, 3u << AMIGA_KBD_DAT_PIN);
+  flush();
+  state    = AMIGA_HOLD;
+  deadline = time_us_64() + AMIGA_RESET_US;
+}
+
+static void reset_warning(void) {
+  flush();
+  restart();
+  send(AMIGA_RESET_WARNING, AMIGA_WARN1, AMIGA_WARNING_US);
+}
+
+void amiga_kbd_key_event(uint8_t keycode, bool pressed) {
+  uint8_t code = AMIGA_NONE;
+
+  if (state >= AMIGA_WARN1)
+    return;
+  if (keycode >= 0xE0) {
+    uint8_t bit = 1 << (keycode & 0x07);
+
+    mods = pressed ? (mods | bit) : (mods & ~bit);
+    // one Ctrl on the Amiga, released when both are up
+    if ((mod_amiga[keycode & 0x07] == AMIGA_CTRL) && ((mods & 0x11) & ~bit))
+      return;
+    if (pressed && (mods & 0x11) && (mods & 0x08) && (mods & 0x80)) {
+      reset_warning();
+      return;
+    }
+    code = mod_amiga[keycode & 0x07];
+  } else if (keycode == 0x39) {
+    // Caps Lock is a toggle: down when the LED goes on, up when it goes off
+    if (pressed) {
+      caps = !caps;
+      queue_code(caps ? AMIGA_CAPS : AMIGA_CAPS | AMIGA_RELEASE);
+    }
+    return;
+  } else if (keycode < sizeof(to_amiga))
+    code = to_amiga[keycode];
+  if (code != AMIGA_NONE)
+    queue_code(pressed ? code : code | AMIGA_RELEASE);
+}
+
+void amiga_kbd_init(void) {
+  pio_sm_claim(AMIGA_KBD_PIO, AMIGA_KBD_SM);
+  offset = pio_add_program(AMIGA_KBD_PIO, &amiga_kbd_program);
+  amiga_kbd_program_init(AMIGA_KBD_PIO, AMIGA_KBD_SM, offset, AMIGA_KBD_DAT_PIN);
+  flush();
+  caps    = false;
+  mods    = 0;
+  lost    = false;
+  powerup = true;
+  sync();
+}
+
+// never waits: the handshake comes back through the rx fifo and every
+// state has a deadline, key events keep queueing meanwhile
+void amiga_kbd_task(void) {
+  uint64_t now = time_us_64();
+  bool handshake = false;
+
+  while (!pio_sm_is_rx_fifo_empty(AMIGA_KBD_PIO, AMIGA_KBD_SM)) {
+    pio_sm_get(AMIGA_KBD_PIO, AMIGA_KBD_SM);
+    handshake = true;
+  }
+  switch (state) {
+  case AMIGA_IDLE:
+    if (size) {
+      uint8_t code = queue[head];
+
+      head = (head + 1) % AMIGA_QUEUE_SIZE;
+      size--;
+      if (code == AMIGA_OVERFLOW)
+	overflow = false;
+      send(code, AMIGA_BUSY, AMIGA_HANDSHAKE_US);
+    }
+    break;
+  case AMIGA_BUSY:
+    if (handshake)
+      state = AMIGA_IDLE;
+    else if (now >= deadline) {
+      if (debug)
+	printf("amiga keyboard lost sync\n");
+      lost = true;
+      sync();
+    }
+    break;
+  case AMIGA_SYNC:
+    if (handshake) {
+      state = AMIGA_IDLE;
+      if (powerup) {
+	flush();
+	queue_code(AMIGA_POWERUP_START);
+	queue_code(AMIGA_POWERUP_END);
+	powerup = false;
+	lost    = false;
+      } else if (lost) {
+	queue_front(current);
+	queue_front(AMIGA_LOST_SYNC);
+	lost = false;
+      }
+    } else if (now >= deadline)
+      sync();
+    break;
+  case AMIGA_WARN1:
+    if (handshake)
+      send(AMIGA_RESET_WARNING, AMIGA_WARN2, AMIGA_CLEANUP_US);
+    else if (now >= deadline)
+      hard_reset();
+    break;
+  case AMIGA_WARN2:
+    // the Amiga holds KDAT low while it cleans up, the release is the handshake
+    if (handshake || (now >= deadline))
+      hard_reset();
+    break;
+  case AMIGA_HOLD:
+    if (now >= deadline) {
+      mods    = 0;
+      powerup = true;
+      sync();
+    }
+    break;
+  }
+}
@@ -0,0 +1,17 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/pio.h"
+
+#define AMIGA_KBD_PIO      pio0
+#define AMIGA_KBD_SM       0
+#define AMIGA_KBD_DAT_PIN  2          // KCLK is GP3
+
+#define AMIGA_QUEUE_SIZE   16
+#define AMIGA_HANDSHAKE_US 143000     // lost sync after that
+#define AMIGA_WARNING_US   250000     // first reset warning not acknowledged
+#define AMIGA_CLEANUP_US   10000000   // the Amiga may hold KDAT that long
+#define AMIGA_RESET_US     500000     // KCLK held low for a hard reset
+
+void amiga_kbd_init(void);
+void amiga_kbd_key_event(uint8_t, bool);
+void amiga_kbd_task(void);
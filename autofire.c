@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/timer.h"
+#include "hardware/sync.h"
+#include "gamepad.h"
+#include "gamepad_state.h"
+#include "joystick.h"
+#include "db9.h"
+#include "gameport.h"
+#include "autofire.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+extern bool debug;
+
+// A / Y about 16 Hz, B / X 10 Hz, half the period pressed
+const AutofireRate autofire_rates[16] = {
+  [4] = { 60000, 30000 },           /* Y */
+  [5] = { 100000, 50000 },          /* X */
+  [6] = { 100000, 50000 },          /* B */
+  [7] = { 60000, 30000 },           /* A */
+};
+
+typedef struct {
+  GamepadState raw;                 // as decoded from the pad
+  uint16_t     enabled;             // buttons with autofire on
+  uint16_t     swallow;             // pressed to toggle, kept off the outputs until released
+  uint16_t     out;                 // buttons last published
+} AutofirePlayer;
+
+// only touched with interrupts off or from the alarm
+static AutofirePlayer players[GAMEPAD_PLAYERS];
+static alarm_id_t     alarm;
+static uint64_t       alarm_at;
+
+// the phase of every button comes from the free running timer, not
+// from when it was pressed: buttons with the same rate stay in step
+// and nothing drifts whatever the alarm latency is
+static uint16_t __not_in_flash_func(output)(const AutofirePlayer *p, uint64_t now, uint64_t *next) {
+  uint16_t held = p->raw.buttons & ~p->swallow;
+  uint16_t fire = held & p->enabled;
+  uint16_t out  = held & ~p->enabled;
+
+  while (fire) {
+    const AutofireRate *r = &autofire_rates[__builtin_ctz(fire)];
+    uint16_t bit = fire & -fire;
+    uint64_t t   = now % r->period_us;
+    uint64_t edge;
+
+    fire &= fire - 1;
+    if (t < r->on_us) {
+      out |= bit;
+      edge = now - t + r->on_us;
+    } else
+      edge = now - t + r->period_us;
+    if (!*next || (edge < *next))
+      *next = edge;
+  }
+  return out;
+}
+
+// timer irq, at every phase edge of any held autofire button
+static int64_t __not_in_flash_func(autofire_edge)(alarm_id_t id, void *user_data) {
+  uint64_t now = time_us_64();
+  uint64_t next = 0;
+  int64_t  delay;
+  int i;
+
+  for (i = 0; i < GAMEPAD_PLAYERS; i++) {
+    AutofirePlayer *p = &players[i];
+    uint16_t out = output(p, now, &next);
+    GamepadState state;
+
+    if (out == p->out)
+      continue;
+    p->out = out;
+    state = p->raw;
+    state.buttons = out;
+    gamepad_publish(i, &state);
+    if (joy_out == JOY_DB9)
+      db9_update(state.hat, out & 0xFF);
+    if ((joy_out == JOY_GAMEPORT) && (i == GAMEPORT_PLAYER))
+      gameport_update(&state);
+  }
+  if (!next) {
+    alarm = 0;
+    return 0;
+  }
+  // negative: relative to when this alarm was due, not to now
+  delay    = next - alarm_at;
+  alarm_at = next;
+  return -delay;
+}
+
+// takes the place of gamepad_publish() for decoded reports: state
+// comes back with the buttons the outputs must see
+void autofire_publish(uint8_t player, GamepadState *state) {
+  AutofirePlayer *p = &players[player];
+  uint16_t pressed = state->buttons & ~p->raw.buttons;
+  uint64_t next = 0;
+  uint32_t irq;
+  int i;
+
+  irq = save_and_disable_interrupts();
+  // only the joystick outputs fire; the keymap profiles bind SELECT
+  // combos of their own and must see them
+  if ((state->buttons & AUTOFIRE_SHIFT) && ((joy_out == JOY_DB9) || (joy_out == JOY_GAMEPORT))) {
+    for (i = 0; i < 16; i++)
+      if ((pressed & (1 << i)) && autofire_rates[i].period_us) {
+	p->enabled ^= 1 << i;
+	p->swallow |= 1 << i;
+	if (debug)
+	  printf("player %d autofire %04x\n", player, p->enabled);
+      }
+  }
+  p->swallow &= state->buttons;
+  p->raw = *state;
+  p->out = output(p, time_us_64(), &next);
+  state->buttons = p->out;
+  // the alarm writes the register too, the masked interrupts keep
+  // it to one writer at a time
+  gamepad_publish(player, state);
+  if (next && (!alarm || (next < alarm_at))) {
+    if (alarm)
+      cancel_alarm(alarm);
+    alarm_at = next;
+    alarm = add_alarm_at(from_us_since_boot(next), autofire_edge, NULL, true);
+    if (alarm < 0)
+      alarm = 0;
+  }
+  restore_interrupts(irq);
+}
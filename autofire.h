@@ -0,0 +1,15 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+// needs gamepad_state.h first
+
+#define AUTOFIRE_SHIFT    GAMEPAD_SELECT   // held: pressing a button toggles its autofire (JOY_DB9 / JOY_GAMEPORT)
+
+typedef struct {
+  uint32_t period_us;               // 0 = this button never autofires
+  uint32_t on_us;                   // pressed part of the period
+} AutofireRate;
+
+extern const AutofireRate autofire_rates[16];   // index is the GAMEPAD_* bit number
+
+void autofire_publish(uint8_t, GamepadState *);
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+#include "c1351.h"
+#include "c1351.pio.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+#define C1351_LATENCY    3          // wait synchronizer + the extra jmp y-- pass
+
+static uint     sm[2];
+static uint32_t sm_hz;
+static uint32_t phi2_hz;
+static uint8_t  pos[2];             // 1351 only reports position modulo 64
+static bool     dirty[2];
+
+// POT value 64..190: position in bits 1..6, bit 0 is noise on a real 1351
+HOTSPOT static uint32_t pot_word(uint8_t p) {
+  uint32_t value = 64 + ((p & 0x3F) << 1);
+  uint32_t delay, hold;
+
+  delay = (((uint64_t) (256 + value) * sm_hz) + phi2_hz / 2) / phi2_hz - C1351_LATENCY;
+  hold  = ((uint64_t) (C1351_RELEASE - 256 - value) * sm_hz) / phi2_hz;
+  return (delay & 0xFFFF) | (hold << 16);
+}
+
+static void button(uint pin, bool pressed) {
+  gpio_set_dir(pin, pressed ? GPIO_OUT : GPIO_IN);
+}
+
+void c1351_init(bool ntsc) {
+  uint32_t clk = clock_get_hz(clk_sys);
+  uint32_t div = (clk + 124999999) / 125000000;   // keep 512 phi2 cycles within 16 bits
+  uint offset;
+  int i;
+
+  sm_hz   = clk / div;
+  phi2_hz = ntsc ? C1351_NTSC_HZ : C1351_PAL_HZ;
+  offset  = pio_add_program(C1351_PIO, &c1351_pot_program);
+  for (i = 0; i < 2; i++) {
+    sm[i]    = pio_claim_unused_sm(C1351_PIO, true);
+    pos[i]   = 0;
+    dirty[i] = false;
+    c1351_pot_program_init(C1351_PIO, sm[i], offset, i ? C1351_PIN_POTY : C1351_PIN_POTX);
+    pio_sm_set_clkdiv(C1351_PIO, sm[i], div);
+    pio_sm_put(C1351_PIO, sm[i], pot_word(pos[i]));
+  }
+  for (i = C1351_PIN_FIRE; i <= C1351_PIN_UP; i++) {
+    gpio_init(i);
+    gpio_put(i, false);
+    gpio_set_dir(i, GPIO_IN);
+  }
+}
+
+void c1351_move(int16_t dx, int16_t dy, bool left, bool right) {
+  // POTY grows when the mouse moves away from the user
+  pos[0] += dx;
+  pos[1] -= dy;
+  dirty[0] = dirty[1] = true;
+  button(C1351_PIN_FIRE, left);
+  button(C1351_PIN_UP, right);
+}
+
+// a new word only goes in once the previous one has been picked up,
+// so the SID always reads a position at most one window old
+void c1351_task(void) {
+  int i;
+
+  for (i = 0; i < 2; i++)
+    if (dirty[i] && pio_sm_is_tx_fifo_empty(C1351_PIO, sm[i])) {
+      pio_sm_put(C1351_PIO, sm[i], pot_word(pos[i]));
+      dirty[i] = false;
+    }
+}
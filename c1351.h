@@ -0,0 +1,18 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/pio.h"
+
+#define C1351_PIO        pio1
+#define C1351_PIN_POTX   6          // DB9 pin 9
+#define C1351_PIN_POTY   7          // DB9 pin 5
+#define C1351_PIN_FIRE   8          // DB9 pin 6, left button
+#define C1351_PIN_UP     9          // DB9 pin 1, right button
+
+#define C1351_PAL_HZ     985248     // phi2
+#define C1351_NTSC_HZ    1022727
+
+#define C1351_RELEASE    500        // phi2 cycle where the line is let go, discharge restarts at 512
+
+void c1351_init(bool);
+void c1351_move(int16_t, int16_t, bool, bool);
+void c1351_task(void);
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "hardware/structs/sio.h"
+#include "db9.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+extern bool debug;
+
+// A / Y fire, B / X second button, index is the GAMEPAD_* bit number
+const Db9Config db9_default = {
+  DB9_UP_PIN, DB9_DOWN_PIN, DB9_LEFT_PIN, DB9_RIGHT_PIN,
+  { DB9_NONE, DB9_NONE, DB9_NONE, DB9_NONE,         /* RIGHT LEFT START SELECT */
+    DB9_FIRE_PIN, DB9_FIRE2_PIN, DB9_FIRE2_PIN, DB9_FIRE_PIN }   /* Y X B A */
+};
+
+// output enables for every direction and every button byte, so an
+// update is two loads and one register write
+static uint32_t dir_mask[9];
+static uint32_t button_mask[256];
+static uint32_t line_mask;
+
+HOTSPOT static uint32_t pin_bit(uint8_t pin) {
+  return (pin == DB9_NONE) ? 0 : 1u << pin;
+}
+
+// called straight from the USB report decode, no queue in between,
+// and from the autofire alarm: the read and toggle must not be split
+void __not_in_flash_func(db9_update)(uint8_t joystick, uint8_t buttons) {
+  uint32_t want = ((joystick < 9) ? dir_mask[joystick] : 0) | button_mask[buttons];
+  uint32_t irq;
+
+  irq = save_and_disable_interrupts();
+  sio_hw->gpio_oe_togl = (sio_hw->gpio_oe ^ want) & line_mask;
+  restore_interrupts(irq);
+}
+
+void db9_init(const Db9Config *config) {
+  uint32_t up    = pin_bit(config->up);
+  uint32_t down  = pin_bit(config->down);
+  uint32_t left  = pin_bit(config->left);
+  uint32_t right = pin_bit(config->right);
+  int i, b;
+
+  // 0 center, 1 up, then clockwise
+  dir_mask[0] = 0;
+  dir_mask[1] = up;
+  dir_mask[2] = up | right;
+  dir_mask[3] = right;
+  dir_mask[4] = down | right;
+  dir_mask[5] = down;
+  dir_mask[6] = down | left;
+  dir_mask[7] = left;
+  dir_mask[8] = up | left;
+  line_mask   = up | down | left | right;
+  for (i = 0; i < 8; i++)
+    line_mask |= pin_bit(config->button[i]);
+  for (i = 0; i < 256; i++) {
+    button_mask[i] = 0;
+    for (b = 0; b < 8; b++)
+      if (i & (1 << b))
+	button_mask[i] |= pin_bit(config->button[b]);
+  }
+  // open collector: the output latch stays low, only the enables move
+  for (i = 0; i < 32; i++)
+    if (line_mask & (1u << i)) {
+      gpio_init(i);
+      gpio_put(i, false);
+      gpio_set_dir(i, GPIO_IN);
+    }
+  if (debug)
+    printf("db9 joystick on %08lx\n", (unsigned long) line_mask);
+}
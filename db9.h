@@ -0,0 +1,21 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+// same DB9 wiring as the quadrature mouse: GP6..GP9 carry pins 1..4
+#define DB9_UP_PIN       6          // DB9 pin 1
+#define DB9_DOWN_PIN     7          // DB9 pin 2
+#define DB9_LEFT_PIN     8          // DB9 pin 3
+#define DB9_RIGHT_PIN    9          // DB9 pin 4
+#define DB9_FIRE_PIN     10         // DB9 pin 6
+#define DB9_FIRE2_PIN    11         // DB9 pin 9, second button (Amiga, MSX, Sega)
+#define DB9_NONE         0xFF
+
+typedef struct {
+  uint8_t up, down, left, right;
+  uint8_t button[8];                // GPIO pulled low by GAMEPAD_* bit n, DB9_NONE = unused
+} Db9Config;
+
+extern const Db9Config db9_default;
+
+void db9_init(const Db9Config *);
+void db9_update(uint8_t, uint8_t);
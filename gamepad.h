@@ -7,3 +7,8 @@
 #define GAMEPAD_START      0x04
 #define GAMEPAD_LEFT       0x02
 #define GAMEPAD_RIGHT      0x01
+#define GAMEPAD_L2         0x0100
+#define GAMEPAD_R2         0x0200
+#define GAMEPAD_HOME       0x0400
+#define GAMEPAD_L3         0x0800
+#define GAMEPAD_R3         0x1000
@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "gamepad.h"
+#include "gamepad_state.h"
+#include "gamepad_decode.h"
+#include "hid_desc.h"
+#include "autofire.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+extern void process_gamepad(uint8_t, const GamepadState *);
+extern void process_gamepad_mount(uint8_t, uint16_t, uint16_t);
+extern bool hid_debug;
+
+typedef struct {
+  const GamepadModel *model;        // NULL = free
+  GamepadModel layout;              // the model, with the offsets of this device
+  uint8_t  dev_addr;
+  uint8_t  instance;
+  bool     valid;                   // last holds a report
+  uint32_t last[GAMEPAD_REPORT_WORDS];
+} GamepadSlot;
+
+static GamepadSlot slots[GAMEPAD_SLOTS];
+
+static GamepadSlot *find_slot(uint8_t dev_addr, uint8_t instance) {
+  int i;
+
+  for (i = 0; i < GAMEPAD_SLOTS; i++)
+    if (slots[i].model && (slots[i].dev_addr == dev_addr) && (slots[i].instance == instance))
+      return &slots[i];
+  return NULL;
+}
+
+// raw byte to -32767..32767, the deadzone is cut out and the rest
+// stretched so the full range is still reached
+HOTSPOT static int16_t axis_value(const GamepadAxis *axis, const uint8_t *report) {
+  int32_t v, range;
+
+  if (axis->offset == GAMEPAD_UNUSED)
+    return 0;
+  v = (int32_t) report[axis->offset] - axis->center;
+  if (abs(v) <= axis->deadzone)
+    return 0;
+  range = ((v > 0) ? 255 - axis->center : axis->center) - axis->deadzone;
+  v = (v > 0) ? v - axis->deadzone : v + axis->deadzone;
+  v = v * GAMEPAD_AXIS_MAX / range;
+  if (v > GAMEPAD_AXIS_MAX)
+    v = GAMEPAD_AXIS_MAX;
+  if (v < -GAMEPAD_AXIS_MAX)
+    v = -GAMEPAD_AXIS_MAX;
+  return axis->invert ? -v : v;
+}
+
+HOTSPOT static uint8_t hat_from_axes(int16_t x, int16_t y) {
+  // [y + 1][x + 1], 0 centered, 1 up, clockwise
+  static const uint8_t dir[3][3] = { { 8, 1, 2 }, { 7, 0, 3 }, { 6, 5, 4 } };
+  int sx = (x > GAMEPAD_AXIS_MAX / 2) ? 1 : (x < -GAMEPAD_AXIS_MAX / 2) ? -1 : 0;
+  int sy = (y > GAMEPAD_AXIS_MAX / 2) ? 1 : (y < -GAMEPAD_AXIS_MAX / 2) ? -1 : 0;
+
+  return dir[sy + 1][sx + 1];
+}
+
+static void decode(const GamepadModel *model, const uint8_t *report, GamepadState *state) {
+  int i;
+
+  for (i = 0; i < GAMEPAD_AXES; i++)
+    state->axis[i] = axis_value(&model->axis[i], report);
+  switch (model->hat) {
+  case GAMEPAD_HAT_AXES:
+    state->hat = hat_from_axes(state->axis[0], state->axis[1]);
+    break;
+  case GAMEPAD_HAT_NIBBLE:
+    state->hat = ((report[model->hat_offset] & 0x0F) < 8) ? (report[model->hat_offset] & 0x0F) + 1 : 0;
+    break;
+  default:
+    state->hat = 0;
+    break;
+  }
+  state->buttons = 0;
+  for (i = 0; i < model->nbuttons; i++)
+    if (report[model->button[i].offset] & model->button[i].mask)
+      state->buttons |= model->button[i].button;
+}
+
+// the descriptor walk: axes by usage, buttons by number, all from
+// the report the first field is in
+typedef struct {
+  GamepadModel *layout;
+  int      id;                      // -1 until the first field
+  uint32_t found;                   // axis bits, 0x10 hat, button n at bit 8 + n
+} GamepadDesc;
+
+static void significant(GamepadModel *layout, uint8_t offset, uint8_t mask) {
+  layout->significant[offset / 4] |= (uint32_t) mask << ((offset % 4) * 8);
+}
+
+static void field_found(void *ctx, const HidDescField *f) {
+  GamepadDesc *d = ctx;
+  GamepadModel *layout = d->layout;
+  int axis = -1;
+  uint8_t offset;
+
+  if (d->id < 0)
+    d->id = f->id;
+  if ((f->id != d->id) || f->array || f->relative)
+    return;
+  if (f->page == HID_PAGE_BUTTON) {
+    offset = f->offset / 8;
+    if ((f->size != 1) || (f->usage < 1) || (f->usage > layout->nbuttons) || (offset >= GAMEPAD_REPORT_MAX - 1))
+      return;
+    d->found |= 1 << (7 + f->usage);
+    layout->button[f->usage - 1].offset = offset;
+    layout->button[f->usage - 1].mask   = 1 << (f->offset % 8);
+    return;
+  }
+  if (f->page != HID_PAGE_DESKTOP)
+    return;
+  switch (f->usage) {
+  case 0x30: axis = 0; break;       // X: roll
+  case 0x31: axis = 1; break;       // Y: pitch
+  case 0x35: axis = 2; break;       // Rz: twist
+  case 0x32:                        // Z or slider: throttle
+  case 0x36: axis = 3; break;
+  case 0x39:                        // hat switch, 0 up clockwise
+    offset = f->offset / 8;
+    if ((layout->hat == GAMEPAD_HAT_NIBBLE) && (f->offset % 8 == 0) && (f->size <= 8) && !f->min &&
+	(offset < GAMEPAD_REPORT_MAX - 1)) {
+      d->found |= 0x10;
+      layout->hat_offset = offset;
+    }
+    return;
+  }
+  // the engine takes 8 bits: the high byte of an unsigned axis
+  offset = (f->offset + f->size) / 8 - 1;
+  if ((axis < 0) || (d->found & (1 << axis)) || (layout->axis[axis].offset == GAMEPAD_UNUSED) ||
+      (f->size < 8) || ((f->offset + f->size) % 8) || (f->min < 0) || (offset >= GAMEPAD_REPORT_MAX - 1))
+    return;
+  d->found |= 1 << axis;
+  layout->axis[axis].offset = offset;
+  layout->axis[axis].center = ((f->min + f->max + 1) / 2) >> (f->size - 8);
+}
+
+// the model's offsets are replaced by what the descriptor says, and
+// only the bytes found there count as a change. the walk counts bits
+// after the report id, the report still starts with it
+static void layout_from_desc(GamepadModel *layout, const uint8_t *desc, uint16_t len) {
+  GamepadDesc d = { layout, -1, 0 };
+  int i;
+
+  if (!hid_desc_walk(desc, len, field_found, &d))
+    d.id = 0;
+  if (!(d.found >> 8))
+    return;
+  for (i = 0; d.id && (i < GAMEPAD_AXES); i++)
+    if (d.found & (1 << i))
+      layout->axis[i].offset++;
+  if (d.id && (d.found & 0x10))
+    layout->hat_offset++;
+  for (i = 0; d.id && (i < layout->nbuttons); i++)
+    if (d.found & (1 << (8 + i)))
+      layout->button[i].offset++;
+  memset(layout->significant, 0, sizeof(layout->significant));
+  for (i = 0; i < GAMEPAD_AXES; i++)
+    if (layout->axis[i].offset != GAMEPAD_UNUSED)
+      significant(layout, layout->axis[i].offset, 0xFC);
+  if (layout->hat == GAMEPAD_HAT_NIBBLE)
+    significant(layout, layout->hat_offset, 0x0F);
+  for (i = 0; i < layout->nbuttons; i++)
+    significant(layout, layout->button[i].offset, layout->button[i].mask);
+  if (hid_debug)
+    printf("%s layout from its descriptor: axes %d %d %d %d, hat %d, button 1 at %d\n", layout->name,
+	   layout->axis[0].offset, layout->axis[1].offset, layout->axis[2].offset, layout->axis[3].offset,
+	   layout->hat_offset, layout->button[0].offset);
+}
+
+bool gamepad_mount(uint8_t dev_addr, uint8_t instance, uint16_t vid, uint16_t pid, const uint8_t *desc, uint16_t len) {
+  int i, j;
+
+  for (i = 0; i < gamepad_nmodels; i++) {
+    if ((gamepad_models[i].vid != vid) || (gamepad_models[i].pid != pid))
+      continue;
+    for (j = 0; j < GAMEPAD_SLOTS; j++)
+      if (!slots[j].model) {
+	slots[j].model    = &gamepad_models[i];
+	slots[j].layout   = gamepad_models[i];
+	slots[j].dev_addr = dev_addr;
+	slots[j].instance = instance;
+	slots[j].valid    = false;
+	if (gamepad_models[i].from_desc)
+	  layout_from_desc(&slots[j].layout, desc, len);
+	if (hid_debug)
+	  printf("%s %0.4x %0.4x connected, player %d\n", gamepad_models[i].name, vid, pid,
+		 gamepad_models[i].player);
+	process_gamepad_mount(gamepad_models[i].player, vid, pid);
+	return true;
+      }
+    printf("no gamepad slot left for %0.4x %0.4x\n", vid, pid);
+    return false;
+  }
+  return false;
+}
+
+// false when the report is not from a gamepad we know. a changed
+// report gives exactly one state update, noise bits never do
+bool gamepad_report(uint8_t dev_addr, uint8_t instance, const uint8_t *report, uint16_t len) {
+  GamepadSlot *slot = find_slot(dev_addr, instance);
+  uint32_t cur[GAMEPAD_REPORT_WORDS] = { 0 };
+  uint32_t diff = 0;
+  GamepadState state;
+  int i;
+
+  if (!slot)
+    return false;
+  memcpy(cur, report, (len < GAMEPAD_REPORT_MAX) ? len : GAMEPAD_REPORT_MAX);
+  for (i = 0; i < GAMEPAD_REPORT_WORDS; i++)
+    diff |= (cur[i] ^ slot->last[i]) & slot->layout.significant[i];
+  if (slot->valid && !diff)
+    return true;
+  memcpy(slot->last, cur, sizeof(cur));
+  slot->valid = true;
+  decode(&slot->layout, (const uint8_t *) cur, &state);
+  autofire_publish(slot->model->player, &state);
+  process_gamepad(slot->model->player, &state);
+  return true;
+}
+
+void gamepad_umount(uint8_t dev_addr, uint8_t instance) {
+  GamepadSlot *slot = find_slot(dev_addr, instance);
+  GamepadState idle = { { 0 } };
+
+  if (!slot)
+    return;
+  if (hid_debug)
+    printf("%s disconnected\n", slot->model->name);
+  // nothing held down on the outputs once the pad is gone
+  autofire_publish(slot->model->player, &idle);
+  process_gamepad(slot->model->player, &idle);
+  slot->model = NULL;
+}
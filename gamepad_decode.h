@@ -0,0 +1,51 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+// needs gamepad_state.h first (GAMEPAD_AXES)
+
+#define GAMEPAD_REPORT_MAX    28
+#define GAMEPAD_REPORT_WORDS  ((GAMEPAD_REPORT_MAX + 3) / 4)
+#define GAMEPAD_MAX_BUTTONS   16
+#define GAMEPAD_SLOTS         4
+#define GAMEPAD_UNUSED        0xFF
+
+#define GAMEPAD_HAT_NONE      0     // no hat, stays centered
+#define GAMEPAD_HAT_AXES      1     // from axes 0 / 1 (digital pads reporting 0x00 / 0x7F / 0xFF)
+#define GAMEPAD_HAT_NIBBLE    2     // low nibble, 0 up clockwise to 7, anything else centered
+
+// report bytes n..n+3 in one change detection word
+#define GAMEPAD_WORD(a, b, c, d) \
+  ((uint32_t) (a) | (uint32_t) (b) << 8 | (uint32_t) (c) << 16 | (uint32_t) (d) << 24)
+
+typedef struct {
+  uint8_t  offset;                  // report byte, GAMEPAD_UNUSED if none
+  uint8_t  center;                  // raw value at rest
+  uint8_t  deadzone;                // raw counts around the center read as 0
+  bool     invert;
+} GamepadAxis;
+
+typedef struct {
+  uint8_t  offset;
+  uint8_t  mask;
+  uint16_t button;                  // GAMEPAD_* bit set while report[offset] & mask
+} GamepadButton;
+
+typedef struct {
+  const char   *name;
+  uint16_t      vid, pid;
+  uint8_t       player;             // gamepad register it publishes to
+  uint32_t      significant[GAMEPAD_REPORT_WORDS];   // bits that count as a change
+  GamepadAxis   axis[GAMEPAD_AXES];
+  uint8_t       hat;                // GAMEPAD_HAT_*
+  uint8_t       hat_offset;
+  uint8_t       nbuttons;
+  GamepadButton button[GAMEPAD_MAX_BUTTONS];
+  bool          from_desc;          // offsets from the report descriptor, the ones above are the fallback
+} GamepadModel;
+
+extern const GamepadModel gamepad_models[];
+extern const int          gamepad_nmodels;
+
+bool gamepad_mount(uint8_t, uint8_t, uint16_t, uint16_t, const uint8_t *, uint16_t);
+bool gamepad_report(uint8_t, uint8_t, const uint8_t *, uint16_t);
+void gamepad_umount(uint8_t, uint8_t);
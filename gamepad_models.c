@@ -0,0 +1,87 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "gamepad.h"
+#include "gamepad_state.h"
+#include "gamepad_decode.h"
+
+#define NO_AXIS  { GAMEPAD_UNUSED, 0, 0, false }
+
+const GamepadModel gamepad_models[] = {
+  {
+    "nintendo gamepad", 0x081f, 0xe401, 0,
+    { GAMEPAD_WORD(0xFF, 0xFF, 0x00, 0x00), GAMEPAD_WORD(0x00, 0xF0, 0x33, 0x00) },
+    { { 0, 0x7F, 0x20, false }, { 1, 0x7F, 0x20, false }, NO_AXIS, NO_AXIS },
+    GAMEPAD_HAT_AXES, 0,
+    8, {
+      { 5, 0x80, GAMEPAD_Y },
+      { 5, 0x40, GAMEPAD_B },
+      { 5, 0x20, GAMEPAD_A },
+      { 5, 0x10, GAMEPAD_X },
+      { 6, 0x20, GAMEPAD_START },
+      { 6, 0x10, GAMEPAD_SELECT },
+      { 6, 0x02, GAMEPAD_RIGHT },
+      { 6, 0x01, GAMEPAD_LEFT }
+    }
+  },
+  {
+    "mini gamepad", 0x0079, 0x0011, 1,
+    { GAMEPAD_WORD(0x00, 0x00, 0x00, 0xFF), GAMEPAD_WORD(0xFF, 0x30, 0x30, 0x00) },
+    { { 3, 0x7F, 0x20, false }, { 4, 0x7F, 0x20, false }, NO_AXIS, NO_AXIS },
+    GAMEPAD_HAT_AXES, 0,
+    4, {
+      { 5, 0x10, GAMEPAD_B },
+      { 5, 0x20, GAMEPAD_A },
+      { 6, 0x20, GAMEPAD_START },
+      { 6, 0x10, GAMEPAD_SELECT }
+    }
+  },
+  {
+    // pressure bytes 7..18 and the low bits of the sticks are noise
+    "glab gamepad", 0x2563, 0x0575, 0,
+    { GAMEPAD_WORD(0xFF, 0x1F, 0x0F, 0xF8), GAMEPAD_WORD(0xF8, 0xF8, 0xF8, 0x00) },
+    { { 3, 0x80, 0x10, false }, { 4, 0x80, 0x10, false },
+      { 5, 0x80, 0x10, false }, { 6, 0x80, 0x10, false } },
+    GAMEPAD_HAT_NIBBLE, 2,
+    13, {
+      { 0, 0x01, GAMEPAD_Y },
+      { 0, 0x02, GAMEPAD_B },
+      { 0, 0x04, GAMEPAD_A },
+      { 0, 0x08, GAMEPAD_X },
+      { 0, 0x10, GAMEPAD_LEFT },
+      { 0, 0x20, GAMEPAD_RIGHT },
+      { 0, 0x40, GAMEPAD_L2 },
+      { 0, 0x80, GAMEPAD_R2 },
+      { 1, 0x01, GAMEPAD_SELECT },
+      { 1, 0x02, GAMEPAD_START },
+      { 1, 0x04, GAMEPAD_L3 },
+      { 1, 0x08, GAMEPAD_R3 },
+      { 1, 0x10, GAMEPAD_HOME }
+    }
+  },
+  {
+    // layout from the report descriptor, these offsets are only used
+    // when it has no buttons. 16 bit axes: their high bytes are decoded
+    "velocityone flightstick", 0x10f5, 0x7055, 0,
+    { GAMEPAD_WORD(0x00, 0xFC, 0x00, 0xFC), GAMEPAD_WORD(0x00, 0xFC, 0xFC, 0x0F),
+      GAMEPAD_WORD(0xFF, 0x07, 0x00, 0x00) },
+    { { 1, 0x80, 0x04, false }, { 3, 0x80, 0x04, false },
+      { 5, 0x80, 0x08, false }, { 6, 0x80, 0x00, true } },
+    GAMEPAD_HAT_NIBBLE, 7,
+    11, {
+      { 8, 0x01, GAMEPAD_A },       /* trigger */
+      { 8, 0x02, GAMEPAD_B },
+      { 8, 0x04, GAMEPAD_X },
+      { 8, 0x08, GAMEPAD_Y },
+      { 8, 0x10, GAMEPAD_LEFT },
+      { 8, 0x20, GAMEPAD_RIGHT },
+      { 8, 0x40, GAMEPAD_L2 },
+      { 8, 0x80, GAMEPAD_R2 },
+      { 9, 0x01, GAMEPAD_SELECT },
+      { 9, 0x02, GAMEPAD_START },
+      { 9, 0x04, GAMEPAD_HOME }
+    },
+    true
+  }
+};
+
+const int gamepad_nmodels = sizeof(gamepad_models) / sizeof(gamepad_models[0]);
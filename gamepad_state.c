@@ -0,0 +1,42 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "gamepad_state.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+static GamepadRegister reg[GAMEPAD_PLAYERS];
+
+// wait-free: the writer never looks at the readers
+void __not_in_flash_func(gamepad_publish)(uint8_t player, const GamepadState *state) {
+  GamepadRegister *r = &reg[player];
+
+  r->seq++;
+  __dmb();
+  r->state = *state;
+  __dmb();
+  r->seq++;
+}
+
+// copy out a consistent snapshot. false when none could be taken (the
+// caller interrupted the writer): keep using the previous one
+bool __not_in_flash_func(gamepad_read)(uint8_t player, GamepadState *state, uint32_t *seq) {
+  GamepadRegister *r = &reg[player];
+  uint32_t s;
+  int i;
+
+  for (i = 0; i < GAMEPAD_READ_TRIES; i++) {
+    s = r->seq;
+    if (s & 1)
+      continue;
+    __dmb();
+    *state = r->state;
+    __dmb();
+    if (r->seq == s) {
+      if (seq)
+	*seq = s;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,23 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GAMEPAD_PLAYERS     2
+#define GAMEPAD_AXES        4       // X, Y, then a second stick or throttle / rudder
+#define GAMEPAD_AXIS_MAX    32767
+#define GAMEPAD_READ_TRIES  4       // a reader that preempted the writer gives up
+
+typedef struct {
+  int16_t  axis[GAMEPAD_AXES];      // -32767..32767, 0 centered, Y down positive
+  uint8_t  hat;                     // 0 centered, 1 up, clockwise up to 8
+  uint16_t buttons;                 // GAMEPAD_* bits
+} GamepadState;
+
+// latest state of one player, written by the USB side and the autofire
+// alarm, one at a time: the sequence is odd while a write is in progress
+typedef struct {
+  volatile uint32_t seq;
+  GamepadState      state;
+} GamepadRegister;
+
+void gamepad_publish(uint8_t, const GamepadState *);
+bool gamepad_read(uint8_t, GamepadState *, uint32_t *);
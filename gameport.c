@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "hardware/structs/sio.h"
+#include "gamepad.h"
+#include "gamepad_state.h"
+#include "gameport.h"
+#include "gameport.pio.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+extern bool debug;
+
+// a 100k pot on a standard card: 24 us + 11 us per kOhm. stick on
+// X1 / Y1, twist on X2, throttle on Y2 as on CH and Thrustmaster sticks
+const GameportConfig gameport_default = {
+  {
+    { 0, 24, 1124, GAMEPORT_SOFT },
+    { 1, 24, 1124, GAMEPORT_SOFT },
+    { 2, 24, 1124, GAMEPORT_LINEAR },
+    { 3, 24, 1124, GAMEPORT_LINEAR }
+  },
+  { 12, 13, 14, 15 },
+  { GAMEPAD_A, GAMEPAD_B, GAMEPAD_X, GAMEPAD_Y }
+};
+
+static const GameportConfig *config;
+static uint     sm[4];
+static uint16_t lut[4][256];        // top 8 bits of the axis to the state machine delay
+static uint32_t last[4];
+static uint32_t line_mask;
+
+// -128..127 to the one-shot length, all integer
+static uint16_t axis_us(const GameportAxis *a, int v) {
+  int32_t x = v * 256 + ((v < 0) ? 0 : 255);           // -32768..32767
+  int32_t us;
+
+  if (a->curve == GAMEPORT_SOFT)
+    x = x / 2 + (int32_t) (((int64_t) x * x * x) >> 31);
+  us = a->min_us + (((int64_t) (x + 32768) * (a->max_us - a->min_us)) >> 16);
+  us -= GAMEPORT_LATENCY_US;
+  return (us < 0) ? 0 : us;
+}
+
+void gameport_init(const GameportConfig *c) {
+  uint32_t clk = clock_get_hz(clk_sys);
+  uint offset;
+  int i, v;
+
+  config    = c;
+  line_mask = 0;
+  offset    = pio_add_program(GAMEPORT_PIO, &gameport_program);
+  gpio_init(GAMEPORT_TRIGGER_PIN);
+  gpio_set_dir(GAMEPORT_TRIGGER_PIN, GPIO_IN);
+  for (i = 0; i < 4; i++) {
+    for (v = -128; v < 128; v++)
+      lut[i][v & 0xFF] = axis_us(&c->axis[i], v);
+    last[i] = lut[i][0];
+    sm[i]   = pio_claim_unused_sm(GAMEPORT_PIO, true);
+    gameport_program_init(GAMEPORT_PIO, sm[i], offset, GAMEPORT_AXIS_PIN + i, GAMEPORT_TRIGGER_PIN);
+    pio_sm_set_clkdiv(GAMEPORT_PIO, sm[i], (float) clk / GAMEPORT_SM_HZ);
+    pio_sm_put(GAMEPORT_PIO, sm[i], last[i]);
+    // buttons are open collector, the card has the pull-ups
+    if (c->button_pin[i] != GAMEPORT_NONE) {
+      line_mask |= 1u << c->button_pin[i];
+      gpio_init(c->button_pin[i]);
+      gpio_put(c->button_pin[i], false);
+      gpio_set_dir(c->button_pin[i], GPIO_IN);
+    }
+  }
+  if (debug)
+    printf("gameport on player %d\n", GAMEPORT_PLAYER);
+}
+
+// a table read per axis; the state machines answer the polls by
+// themselves. called from the USB decode and the autofire alarm
+void __not_in_flash_func(gameport_update)(const GamepadState *state) {
+  uint32_t want = 0;
+  uint32_t irq;
+  int i;
+
+  irq = save_and_disable_interrupts();
+  for (i = 0; i < 4; i++) {
+    uint8_t a = config->axis[i].axis;
+    uint32_t us = lut[i][(a == GAMEPORT_NONE) ? 0 : (uint8_t) (state->axis[a] >> 8)];
+
+    if ((us != last[i]) && !pio_sm_is_tx_fifo_full(GAMEPORT_PIO, sm[i])) {
+      pio_sm_put(GAMEPORT_PIO, sm[i], us);
+      last[i] = us;
+    }
+    if ((config->button_pin[i] != GAMEPORT_NONE) && (state->buttons & config->button[i]))
+      want |= 1u << config->button_pin[i];
+  }
+  sio_hw->gpio_oe_togl = (sio_hw->gpio_oe ^ want) & line_mask;
+  restore_interrupts(irq);
+}
@@ -0,0 +1,35 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/pio.h"
+
+// needs gamepad_state.h first
+
+#define GAMEPORT_PIO          pio1          // not together with the C1351 mouse
+#define GAMEPORT_PLAYER       0
+#define GAMEPORT_AXIS_PIN     18            // GP18..GP21 axis switches, gameport pins 3, 6, 11, 13
+#define GAMEPORT_TRIGGER_PIN  22            // high while the 558s run
+#define GAMEPORT_NONE         0xFF
+
+#define GAMEPORT_LATENCY_US   2             // trigger sampling + switch and capacitor
+#define GAMEPORT_SM_HZ        4000000
+
+#define GAMEPORT_LINEAR       0
+#define GAMEPORT_SOFT         1             // half linear, half cubic: finer around the center
+
+typedef struct {
+  uint8_t  axis;                    // GamepadState axis, GAMEPORT_NONE = always centered
+  uint16_t min_us;                  // one-shot length at either end of the axis
+  uint16_t max_us;
+  uint8_t  curve;                   // GAMEPORT_LINEAR, GAMEPORT_SOFT
+} GameportAxis;
+
+typedef struct {
+  GameportAxis axis[4];             // X1, Y1, X2, Y2
+  uint8_t      button_pin[4];       // gameport pins 2, 7, 10, 14
+  uint16_t     button[4];           // GAMEPAD_* bits pressing each one
+} GameportConfig;
+
+extern const GameportConfig gameport_default;
+
+void gameport_init(const GameportConfig *);
+void gameport_update(const GamepadState *);
@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hid_desc.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+extern bool debug;
+
+HOTSPOT static int32_t item_value(const uint8_t *p, int size, bool is_signed) {
+  switch (size) {
+  case 1:
+    return is_signed ? (int8_t) p[0] : p[0];
+  case 2:
+    return is_signed ? (int16_t) (p[0] | (p[1] << 8)) : (p[0] | (p[1] << 8));
+  case 4:
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+  }
+  return 0;
+}
+
+// short items only, every data field of the input reports goes to fn:
+// variables one by one with their usage, arrays one per element with
+// the usage range of their values. returns whether report ids are used
+bool hid_desc_walk(const uint8_t *desc, uint16_t len, HidDescFn fn, void *ctx) {
+  static uint16_t bits[256];        // next bit of every report id
+  uint16_t usages[HID_DESC_USAGES];
+  uint16_t page = 0, usage_min = 0, usage_max = 0;
+  int32_t  lmin = 0, lmax = 0;
+  uint8_t  size = 0, count = 0, id = 0, nusages = 0;
+  const uint8_t *end = desc + len;
+  bool has_id = false;
+  HidDescField f;
+  int i;
+
+  memset(bits, 0, sizeof(bits));
+  while (desc < end) {
+    uint8_t prefix = *desc++;
+    int     n = ((prefix & 0x03) == 3) ? 4 : (prefix & 0x03);
+    int32_t v;
+
+    if (prefix == 0xFE) {           // long item
+      if (desc + 1 >= end)
+	break;
+      desc += 2 + desc[0];
+      continue;
+    }
+    if (desc + n > end)
+      break;
+    v = item_value(desc, n, false);
+    switch (prefix & 0xFC) {
+    case 0x04:                      // usage page
+      page = v;
+      break;
+    case 0x14:                      // logical minimum
+      lmin = item_value(desc, n, true);
+      break;
+    case 0x24:                      // logical maximum, unsigned when the minimum is
+      lmax = (lmin < 0) ? item_value(desc, n, true) : v;
+      break;
+    case 0x74:                      // report size
+      size = v;
+      break;
+    case 0x84:                      // report id
+      id = v;
+      has_id = true;
+      break;
+    case 0x94:                      // report count
+      count = v;
+      break;
+    case 0x08:                      // usage
+      if (nusages < HID_DESC_USAGES)
+	usages[nusages++] = v;
+      break;
+    case 0x18:                      // usage minimum
+      usage_min = v;
+      break;
+    case 0x28:                      // usage maximum
+      usage_max = v;
+      break;
+    case 0x80:                      // input
+      f.page     = page;
+      f.id       = id;
+      f.size     = size;
+      f.min      = lmin;
+      f.max      = lmax;
+      f.array    = !(v & 0x02);
+      f.relative = (v & 0x04) != 0;
+      for (i = 0; !(v & 0x01) && (i < count); i++) {
+	f.offset = bits[id] + i * size;
+	if (f.array) {
+	  f.usage     = nusages ? usages[0] : usage_min;
+	  f.usage_max = nusages ? usages[nusages - 1] : usage_max;
+	} else if (nusages)
+	  f.usage = usages[(i < nusages) ? i : nusages - 1];
+	else if (usage_min + i <= usage_max)
+	  f.usage = usage_min + i;
+	else
+	  break;
+	fn(ctx, &f);
+      }
+      bits[id] += size * count;
+      // fall through: locals end with every main item
+    case 0x90:                      // output
+    case 0xB0:                      // feature
+    case 0xA0:                      // collection
+    case 0xC0:                      // end collection
+      nusages   = 0;
+      usage_min = 0;
+      usage_max = 0;
+      break;
+    }
+    desc += n;
+  }
+  return has_id;
+}
+
+// the field out of a report without its id, sign extended when the
+// logical minimum is negative
+int32_t hid_desc_value(const HidDescField *f, const uint8_t *report, uint16_t len) {
+  uint32_t v = 0;
+  int i, bit;
+
+  if (!f->size || (f->size > 32) || ((f->offset + f->size + 7) / 8 > len))
+    return 0;
+  for (i = 0; i < f->size; i++) {
+    bit = f->offset + i;
+    v |= (uint32_t) ((report[bit >> 3] >> (bit & 7)) & 1) << i;
+  }
+  if ((f->min < 0) && (f->size < 32) && (v & (1u << (f->size - 1))))
+    v |= ~0u << f->size;
+  return v;
+}
@@ -0,0 +1,39 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HID_DESC_USAGES   16        // local usages kept per main item
+
+#define HID_PAGE_DESKTOP    0x01
+#define HID_PAGE_BUTTON     0x09
+#define HID_PAGE_CONSUMER   0x0C
+#define HID_PAGE_DIGITIZER  0x0D
+
+// report id dispatch, one byte per id
+#define HID_ROUTE_SLOTS     4
+#define HID_ROUTE_POINTER   0x01
+#define HID_ROUTE_MEDIA     0x02
+
+typedef struct {
+  uint8_t  dev_addr;                // 0 = free
+  uint8_t  instance;
+  bool     has_id;                  // reports start with their id
+  uint8_t  route[256];
+} HidRoutes;
+
+// one input field, as found in the report descriptor
+typedef struct {
+  uint16_t page;
+  uint16_t usage;                   // arrays: the usage of the lowest value
+  uint16_t usage_max;               // arrays: the usage of the highest value
+  uint8_t  id;
+  uint16_t offset;                  // bit, after the report id
+  uint8_t  size;
+  int32_t  min, max;
+  bool     array;
+  bool     relative;
+} HidDescField;
+
+typedef void (*HidDescFn)(void *, const HidDescField *);
+
+bool hid_desc_walk(const uint8_t *, uint16_t, HidDescFn, void *);
+int32_t hid_desc_value(const HidDescField *, const uint8_t *, uint16_t);
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hid_desc.h"
+#include "hid_media.h"
+#include "kbd.h"
+
+extern void process_media_key(uint8_t, bool);
+extern bool hid_debug;
+
+typedef struct {
+  uint16_t page;
+  uint16_t usage;
+  uint8_t  key;
+} MediaUsage;
+
+static const MediaUsage media_usages[] = {
+  { HID_PAGE_CONSUMER, 0x0CD, KBD_KEY_PLAY },
+  { HID_PAGE_CONSUMER, 0x0B7, KBD_KEY_STOP },
+  { HID_PAGE_CONSUMER, 0x0B5, KBD_KEY_NEXT },
+  { HID_PAGE_CONSUMER, 0x0B6, KBD_KEY_PREV },
+  { HID_PAGE_CONSUMER, 0x0E2, KBD_KEY_MUTE },
+  { HID_PAGE_CONSUMER, 0x0E9, KBD_KEY_VOLUP },
+  { HID_PAGE_CONSUMER, 0x0EA, KBD_KEY_VOLDN },
+  { HID_PAGE_CONSUMER, 0x192, KBD_KEY_CALC },
+  { HID_PAGE_CONSUMER, 0x18A, KBD_KEY_MAIL },
+  { HID_PAGE_CONSUMER, 0x223, KBD_KEY_WWW },
+  { HID_PAGE_CONSUMER, 0x221, KBD_KEY_SEARCH },
+  { HID_PAGE_CONSUMER, 0x224, KBD_KEY_BACK },
+  { HID_PAGE_CONSUMER, 0x225, KBD_KEY_FORWARD },
+  { HID_PAGE_CONSUMER, 0x194, KBD_KEY_COMPUTER },
+  // system control, generic desktop page
+  { HID_PAGE_DESKTOP,  0x081, KBD_KEY_POWER },
+  { HID_PAGE_DESKTOP,  0x082, KBD_KEY_SLEEP },
+  { HID_PAGE_DESKTOP,  0x083, KBD_KEY_WAKE }
+};
+
+#define MEDIA_USAGES (sizeof(media_usages) / sizeof(media_usages[0]))
+
+static HidMedia slots[HID_MEDIA_SLOTS];
+
+static HidMedia *find_slot(uint8_t dev_addr, uint8_t instance) {
+  int i;
+
+  for (i = 0; i < HID_MEDIA_SLOTS; i++)
+    if ((slots[i].dev_addr == dev_addr) && (!dev_addr || (slots[i].instance == instance)))
+      return &slots[i];
+  return NULL;
+}
+
+static uint8_t media_key(uint16_t page, uint16_t usage) {
+  int i;
+
+  for (i = 0; i < MEDIA_USAGES; i++)
+    if ((media_usages[i].page == page) && (media_usages[i].usage == usage))
+      return media_usages[i].key;
+  return 0;
+}
+
+// an array is kept when its usage range holds any of the keys
+static bool wanted(const HidDescField *f) {
+  int i;
+
+  if (!f->array)
+    return media_key(f->page, f->usage) != 0;
+  for (i = 0; i < MEDIA_USAGES; i++)
+    if ((media_usages[i].page == f->page) && (media_usages[i].usage >= f->usage) &&
+	(media_usages[i].usage <= f->usage_max))
+      return true;
+  return false;
+}
+
+static void field_found(void *ctx, const HidDescField *f) {
+  HidMedia *media = ctx;
+  int i;
+
+  if ((media->nfields == HID_MEDIA_FIELDS) || !wanted(f))
+    return;
+  for (i = 0; (i < media->nids) && (media->id[i] != f->id); i++)
+    ;
+  if (i == media->nids) {
+    if (i == HID_MEDIA_IDS)
+      return;
+    media->id[media->nids++] = f->id;
+  }
+  media->field[media->nfields++] = *f;
+}
+
+bool hid_media_mount(uint8_t dev_addr, uint8_t instance, const uint8_t *desc, uint16_t len, HidRoutes *routes) {
+  HidMedia *media = find_slot(0, 0);
+  int i;
+
+  if (!media)
+    return false;
+  memset(media, 0, sizeof(*media));
+  media->has_id = hid_desc_walk(desc, len, field_found, media);
+  if (!media->nfields)
+    return false;
+  media->dev_addr = dev_addr;
+  media->instance = instance;
+  routes->has_id = media->has_id;
+  for (i = 0; i < media->nids; i++)
+    routes->route[media->id[i]] |= HID_ROUTE_MEDIA;
+  if (hid_debug)
+    printf("media keys, %d fields in %d reports\n", media->nfields, media->nids);
+  return true;
+}
+
+// keys held in the report against the ones it held last time, other
+// report ids keep theirs
+void hid_media_report(uint8_t dev_addr, uint8_t instance, const uint8_t *report, uint16_t len) {
+  HidMedia *media = find_slot(dev_addr, instance);
+  const HidDescField *f;
+  uint32_t held = 0, changed;
+  uint8_t id = 0, key;
+  int32_t v;
+  int i;
+
+  if (!media)
+    return;
+  if (media->has_id) {
+    id = *report++;
+    len--;
+  }
+  for (i = 0; (i < media->nids) && (media->id[i] != id); i++)
+    ;
+  if (i == media->nids)
+    return;
+  for (f = media->field; f < media->field + media->nfields; f++) {
+    if (f->id != id)
+      continue;
+    v = hid_desc_value(f, report, len);
+    if (!f->array)
+      key = v ? media_key(f->page, f->usage) : 0;
+    else if ((v >= f->min) && (v <= f->max) && (f->usage + (v - f->min) <= f->usage_max))
+      key = media_key(f->page, f->usage + (v - f->min));
+    else
+      key = 0;
+    if (key)
+      held |= 1u << (key - KBD_KEY_MEDIA);
+  }
+  for (changed = held ^ media->held[i]; changed; changed &= changed - 1) {
+    key = __builtin_ctz(changed);
+    process_media_key(KBD_KEY_MEDIA + key, (held >> key) & 1);
+  }
+  media->held[i] = held;
+}
+
+// nothing stays pressed on the outputs once the device is gone
+void hid_media_umount(uint8_t dev_addr, uint8_t instance) {
+  HidMedia *media = find_slot(dev_addr, instance);
+  uint32_t held;
+  int i;
+
+  if (!media)
+    return;
+  for (i = 0; i < media->nids; i++)
+    for (held = media->held[i]; held; held &= held - 1)
+      process_media_key(KBD_KEY_MEDIA + __builtin_ctz(held), false);
+  memset(media, 0, sizeof(*media));
+}
@@ -0,0 +1,23 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+// needs hid_desc.h first
+
+#define HID_MEDIA_SLOTS   4
+#define HID_MEDIA_FIELDS  24        // consumer bitmaps have one field per key
+#define HID_MEDIA_IDS     4         // report ids with media fields per interface
+
+typedef struct {
+  uint8_t      dev_addr;            // 0 = free
+  uint8_t      instance;
+  bool         has_id;
+  uint8_t      nfields;
+  HidDescField field[HID_MEDIA_FIELDS];
+  uint8_t      nids;
+  uint8_t      id[HID_MEDIA_IDS];
+  uint32_t     held[HID_MEDIA_IDS]; // bit n is KBD_KEY_MEDIA + n
+} HidMedia;
+
+bool hid_media_mount(uint8_t, uint8_t, const uint8_t *, uint16_t, HidRoutes *);
+void hid_media_report(uint8_t, uint8_t, const uint8_t *, uint16_t);
+void hid_media_umount(uint8_t, uint8_t);
@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "hid_merge.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+#define KEY_ROLLOVER    0x01        // too many keys, the report means nothing
+
+extern void process_keycode(uint8_t, uint8_t);
+extern void process_key_event(uint8_t, bool);
+extern void process_mouse(int16_t, int16_t, int8_t, int8_t, uint8_t);
+extern bool debug;
+extern bool numlock_state;
+extern bool capslock_state;
+extern bool scrolllock_state;
+
+static MergeKbd   kbds[HID_MERGE_KBDS];
+static MergeMouse mice[HID_MERGE_MICE];
+static uint8_t    modifier;         // of the merged keyboard
+static uint32_t   keys[8];
+
+static MergeKbd *find_kbd(uint8_t dev_addr, uint8_t instance) {
+  int i;
+
+  for (i = 0; i < HID_MERGE_KBDS; i++)
+    if ((kbds[i].dev_addr == dev_addr) && (!dev_addr || (kbds[i].instance == instance)))
+      return &kbds[i];
+  return NULL;
+}
+
+static MergeMouse *find_mouse(uint8_t dev_addr, uint8_t instance) {
+  int i;
+
+  for (i = 0; i < HID_MERGE_MICE; i++)
+    if ((mice[i].dev_addr == dev_addr) && (!dev_addr || (mice[i].instance == instance)))
+      return &mice[i];
+  return NULL;
+}
+
+// usb_hid.c keeps numlock_state inverted
+HOTSPOT static uint8_t lock_leds(void) {
+  return (numlock_state ? 0 : KEYBOARD_LED_NUMLOCK) | (capslock_state ? KEYBOARD_LED_CAPSLOCK : 0) |
+    (scrolllock_state ? KEYBOARD_LED_SCROLLLOCK : 0);
+}
+
+static void lock_key(uint8_t keycode) {
+  switch (keycode) {
+  case 0x39:
+    capslock_state = !capslock_state;
+    break;
+  case 0x47:
+    scrolllock_state = !scrolllock_state;
+    break;
+  case 0x53:
+    numlock_state = !numlock_state;
+    break;
+  default:
+    process_keycode(keycode, modifier);
+    break;
+  }
+}
+
+// the keyboards together are one keyboard: a key is down while any of
+// them holds it, and only changes of the union become events
+static void merge_keys(void) {
+  uint32_t now[8] = { 0 }, changed;
+  uint8_t mod = 0, mods;
+  int i, w;
+
+  for (i = 0; i < HID_MERGE_KBDS; i++) {
+    if (!kbds[i].dev_addr)
+      continue;
+    mod |= kbds[i].modifier;
+    for (w = 0; w < 8; w++)
+      now[w] |= kbds[i].keys[w];
+  }
+  for (mods = mod ^ modifier, i = 0; i < 8; i++)
+    if (mods & (1 << i))
+      process_key_event(0xE0 + i, (mod & (1 << i)) ? true : false);
+  modifier = mod;
+  for (w = 0; w < 8; w++)
+    for (changed = keys[w] & ~now[w]; changed; changed &= changed - 1)
+      process_key_event(w * 32 + __builtin_ctz(changed), false);
+  for (w = 0; w < 8; w++)
+    for (changed = now[w] & ~keys[w]; changed; changed &= changed - 1)
+      process_key_event(w * 32 + __builtin_ctz(changed), true);
+  for (w = 0; w < 8; w++)
+    for (changed = now[w] & ~keys[w]; changed; changed &= changed - 1)
+      lock_key(w * 32 + __builtin_ctz(changed));
+  memcpy(keys, now, sizeof(keys));
+}
+
+void hid_merge_kbd_mount(uint8_t dev_addr, uint8_t instance) {
+  MergeKbd *kbd = find_kbd(0, 0);
+
+  if (!kbd) {
+    printf("too many keyboards\n");
+    return;
+  }
+  memset(kbd, 0, sizeof(*kbd));
+  kbd->dev_addr  = dev_addr;
+  kbd->instance  = instance;
+  kbd->leds_sent = 0xFF;
+}
+
+void hid_merge_kbd_report(uint8_t dev_addr, uint8_t instance, const hid_keyboard_report_t *report) {
+  MergeKbd *kbd = find_kbd(dev_addr, instance);
+  uint8_t keycode;
+  int i;
+
+  if (!kbd || (report->keycode[0] == KEY_ROLLOVER))
+    return;
+  kbd->modifier = report->modifier;
+  memset(kbd->keys, 0, sizeof(kbd->keys));
+  for (i = 0; i < sizeof(report->keycode); i++)
+    if ((keycode = report->keycode[i]) > 0x03)
+      kbd->keys[keycode >> 5] |= 1u << (keycode & 0x1F);
+  merge_keys();
+}
+
+// what it held is released, unless another keyboard holds it too
+void hid_merge_kbd_umount(uint8_t dev_addr, uint8_t instance) {
+  MergeKbd *kbd = find_kbd(dev_addr, instance);
+
+  if (!kbd)
+    return;
+  memset(kbd, 0, sizeof(*kbd));
+  merge_keys();
+}
+
+void hid_merge_leds_done(uint8_t dev_addr, uint8_t instance) {
+  MergeKbd *kbd = find_kbd(dev_addr, instance);
+
+  if (kbd)
+    kbd->leds_busy = false;
+}
+
+static uint8_t mouse_buttons(void) {
+  uint8_t held = 0;
+  int i;
+
+  for (i = 0; i < HID_MERGE_MICE; i++)
+    if (mice[i].dev_addr)
+      held |= mice[i].buttons;
+  return held;
+}
+
+// buttons are held while any mouse holds them, the deltas add up in
+// the ring buffer and the outputs
+void hid_merge_mouse(uint8_t dev_addr, uint8_t instance, int16_t dx, int16_t dy, int8_t dw, int8_t pan, uint8_t buttons) {
+  MergeMouse *mouse = find_mouse(dev_addr, instance);
+
+  if (!mouse && (mouse = find_mouse(0, 0))) {
+    mouse->dev_addr = dev_addr;
+    mouse->instance = instance;
+  }
+  if (!mouse) {
+    process_mouse(dx, dy, dw, pan, mouse_buttons() | buttons);
+    return;
+  }
+  mouse->buttons = buttons;
+  process_mouse(dx, dy, dw, pan, mouse_buttons());
+}
+
+void hid_merge_mouse_umount(uint8_t dev_addr, uint8_t instance) {
+  MergeMouse *mouse = find_mouse(dev_addr, instance);
+  bool held;
+
+  if (!mouse)
+    return;
+  held = mouse->buttons != 0;
+  memset(mouse, 0, sizeof(*mouse));
+  if (held)
+    process_mouse(0, 0, 0, 0, mouse_buttons());
+}
+
+// lock state is global: every keyboard shows it. one set_report at a
+// time per keyboard, so a burst of toggles ends in one transfer
+void hid_merge_task(void) {
+  uint8_t leds = lock_leds();
+  int i;
+
+  for (i = 0; i < HID_MERGE_KBDS; i++) {
+    MergeKbd *kbd = &kbds[i];
+
+    if (!kbd->dev_addr || kbd->leds_busy || (kbd->leds_sent == leds))
+      continue;
+    kbd->leds = leds;
+    if (tuh_hid_set_report(kbd->dev_addr, kbd->instance, 0, HID_REPORT_TYPE_OUTPUT, &kbd->leds, sizeof(kbd->leds))) {
+      kbd->leds_busy = true;
+      kbd->leds_sent = leds;
+    }
+  }
+}
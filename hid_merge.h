@@ -0,0 +1,31 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+// needs tusb.h first
+
+#define HID_MERGE_KBDS    4
+#define HID_MERGE_MICE    4
+
+typedef struct {
+  uint8_t  dev_addr;                // 0 = free
+  uint8_t  instance;
+  uint8_t  modifier;
+  uint32_t keys[8];                 // bitmap of the usages held
+  uint8_t  leds;                    // set_report buffer, valid until it completes
+  uint8_t  leds_sent;               // 0xFF: never sent
+  bool     leds_busy;
+} MergeKbd;
+
+typedef struct {
+  uint8_t  dev_addr;
+  uint8_t  instance;
+  uint8_t  buttons;
+} MergeMouse;
+
+void hid_merge_kbd_mount(uint8_t, uint8_t);
+void hid_merge_kbd_report(uint8_t, uint8_t, const hid_keyboard_report_t *);
+void hid_merge_kbd_umount(uint8_t, uint8_t);
+void hid_merge_leds_done(uint8_t, uint8_t);
+void hid_merge_mouse(uint8_t, uint8_t, int16_t, int16_t, int8_t, int8_t, uint8_t);
+void hid_merge_mouse_umount(uint8_t, uint8_t);
+void hid_merge_task(void);
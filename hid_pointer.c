@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hid_desc.h"
+#include "hid_pointer.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+extern void hid_merge_mouse(uint8_t, uint8_t, int16_t, int16_t, int8_t, int8_t, uint8_t);
+extern void process_pointer(uint16_t, uint16_t, bool, uint8_t, int8_t);
+extern bool hid_debug;
+
+static HidPointer slots[HID_POINTER_SLOTS];
+
+static HidPointer *find_slot(uint8_t dev_addr, uint8_t instance) {
+  int i;
+
+  for (i = 0; i < HID_POINTER_SLOTS; i++)
+    if ((slots[i].dev_addr == dev_addr) && (!dev_addr || (slots[i].instance == instance)))
+      return &slots[i];
+  return NULL;
+}
+
+static HidDescField *field_for(HidPointer *ptr, uint16_t page, uint16_t usage) {
+  switch (page) {
+  case HID_PAGE_DESKTOP:
+    return (usage == 0x30) ? &ptr->x : (usage == 0x31) ? &ptr->y : (usage == 0x38) ? &ptr->wheel : NULL;
+  case HID_PAGE_BUTTON:
+    return ((usage >= 1) && (usage <= HID_POINTER_BUTTONS)) ? &ptr->button[usage - 1] : NULL;
+  case HID_PAGE_DIGITIZER:
+    // tip is the left button, the barrel switch the right one
+    return (usage == 0x42) ? &ptr->button[0] : (usage == 0x44) ? &ptr->button[1] :
+      (usage == 0x32) ? &ptr->in_range : NULL;
+  }
+  return NULL;
+}
+
+// only what a pointer needs: the first X / Y of the input reports and
+// the buttons, wheel and in range fields of the same report
+static void field_found(void *ctx, const HidDescField *f) {
+  HidPointer *ptr = ctx;
+  HidDescField *to;
+
+  if (f->array || !(to = field_for(ptr, f->page, f->usage)) || to->size)
+    return;
+  if (ptr->x.size && (f->id != ptr->x.id))
+    return;
+  *to = *f;
+}
+
+bool hid_pointer_mount(uint8_t dev_addr, uint8_t instance, const uint8_t *desc, uint16_t len, HidRoutes *routes) {
+  HidPointer *ptr = find_slot(0, 0);
+  int i;
+
+  if (!ptr)
+    return false;
+  memset(ptr, 0, sizeof(*ptr));
+  ptr->has_id = hid_desc_walk(desc, len, field_found, ptr);
+  if (!ptr->x.size || !ptr->y.size || (ptr->x.id != ptr->y.id))
+    return false;
+  // buttons may come before X, in another report
+  for (i = 0; i < HID_POINTER_BUTTONS; i++)
+    if (ptr->button[i].id != ptr->x.id)
+      ptr->button[i].size = 0;
+  if (ptr->wheel.id != ptr->x.id)
+    ptr->wheel.size = 0;
+  if (ptr->in_range.id != ptr->x.id)
+    ptr->in_range.size = 0;
+  ptr->dev_addr = dev_addr;
+  ptr->instance = instance;
+  routes->has_id = ptr->has_id;
+  routes->route[ptr->x.id] |= HID_ROUTE_POINTER;
+  if (hid_debug)
+    printf("%s pointer, X %d bits %d..%d, report id %d\n", ptr->x.relative ? "relative" : "absolute",
+	   ptr->x.size, ptr->x.min, ptr->x.max, ptr->x.id);
+  return true;
+}
+
+// logical range to 0..65535, i.e. [0, 1) in Q16
+HOTSPOT static uint16_t normalize(const HidDescField *f, int32_t v) {
+  int64_t span = (int64_t) f->max - f->min + 1;
+
+  if (span <= 0)
+    return 0;
+  v = (v < f->min) ? f->min : (v > f->max) ? f->max : v;
+  return (((int64_t) v - f->min) << 16) / span;
+}
+
+void hid_pointer_report(uint8_t dev_addr, uint8_t instance, const uint8_t *report, uint16_t len) {
+  HidPointer *ptr = find_slot(dev_addr, instance);
+  uint8_t buttons = 0;
+  int8_t  wheel;
+  bool    prox;
+  int i;
+
+  if (!ptr)
+    return;
+  if (ptr->has_id) {
+    report++;
+    len--;
+  }
+  for (i = 0; i < HID_POINTER_BUTTONS; i++)
+    if (hid_desc_value(&ptr->button[i], report, len))
+      buttons |= 1 << i;
+  wheel = hid_desc_value(&ptr->wheel, report, len);
+  if (ptr->x.relative) {
+    hid_merge_mouse(dev_addr, instance, hid_desc_value(&ptr->x, report, len), hid_desc_value(&ptr->y, report, len),
+		    wheel, 0, buttons);
+    return;
+  }
+  prox = ptr->in_range.size ? (hid_desc_value(&ptr->in_range, report, len) != 0) : true;
+  process_pointer(normalize(&ptr->x, hid_desc_value(&ptr->x, report, len)),
+		  normalize(&ptr->y, hid_desc_value(&ptr->y, report, len)), prox, buttons, wheel);
+}
+
+void hid_pointer_umount(uint8_t dev_addr, uint8_t instance) {
+  HidPointer *ptr = find_slot(dev_addr, instance);
+
+  if (ptr)
+    memset(ptr, 0, sizeof(*ptr));
+}
@@ -0,0 +1,21 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+// needs hid_desc.h first
+
+#define HID_POINTER_SLOTS    2
+#define HID_POINTER_BUTTONS  5      // left, right, middle, back, forward
+#define HID_POINTER_SPAN     2048   // counts across the whole range, for relative outputs
+
+// a field with size 0 is not in the report
+typedef struct {
+  uint8_t      dev_addr;            // 0 = free
+  uint8_t      instance;
+  bool         has_id;
+  HidDescField x, y, wheel, in_range;
+  HidDescField button[HID_POINTER_BUTTONS];
+} HidPointer;
+
+bool hid_pointer_mount(uint8_t, uint8_t, const uint8_t *, uint16_t, HidRoutes *);
+void hid_pointer_report(uint8_t, uint8_t, const uint8_t *, uint16_t);
+void hid_pointer_umount(uint8_t, uint8_t);
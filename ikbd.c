@@ -0,0 +1,422 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/uart.h"
+#include "hardware/gpio.h"
+#include "gamepad.h"
+#include "gamepad_state.h"
+#include "ikbd.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+#define IKBD_MOUSE_REL      0
+#define IKBD_MOUSE_ABS      1
+#define IKBD_MOUSE_KEYCODE  2
+#define IKBD_MOUSE_OFF      3
+
+#define IKBD_JOY_EVENT      0
+#define IKBD_JOY_INTERROGATE 1
+#define IKBD_JOY_OFF        2
+
+#define IKBD_UART_FIFO      32
+
+extern bool debug;
+
+typedef struct {
+  uint8_t len;
+  uint8_t data[IKBD_PACKET_MAX];
+} IkbdPacket;
+
+// USB HID usage to ST scancode, break codes have bit 7 set
+static const uint8_t to_st[0x65] = {
+  0x00, 0x00, 0x00, 0x00, 0x1E, 0x30, 0x2E, 0x20,   /* 0x00 */
+  0x12, 0x21, 0x22, 0x23, 0x17, 0x24, 0x25, 0x26,   /* 0x08 */
+  0x32, 0x31, 0x18, 0x19, 0x10, 0x13, 0x1F, 0x14,   /* 0x10 */
+  0x16, 0x2F, 0x11, 0x2D, 0x15, 0x2C, 0x02, 0x03,   /* 0x18 */
+  0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B,   /* 0x20 */
+  0x1C, 0x01, 0x0E, 0x0F, 0x39, 0x0C, 0x0D, 0x1A,   /* 0x28 */
+  0x1B, 0x2B, 0x2B, 0x27, 0x28, 0x29, 0x33, 0x34,   /* 0x30 */
+  0x35, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F, 0x40,   /* 0x38 */
+  0x41, 0x42, 0x43, 0x44, 0x63, 0x64, 0x00, 0x00,   /* 0x40 F11 F12 = keypad ( ) */
+  0x00, 0x52, 0x47, 0x62, 0x53, 0x00, 0x61, 0x4D,   /* 0x48 PGUP = HELP, PGDN = UNDO */
+  0x4B, 0x50, 0x48, 0x00, 0x65, 0x66, 0x4A, 0x4E,   /* 0x50 */
+  0x72, 0x6D, 0x6E, 0x6F, 0x6A, 0x6B, 0x6C, 0x67,   /* 0x58 */
+  0x68, 0x69, 0x70, 0x71, 0x60                      /* 0x60 */
+};
+
+static const uint8_t mod_st[8] = { 0x1D, 0x2A, 0x38, 0x00, 0x1D, 0x36, 0x38, 0x00 };
+
+// parameter bytes following each command, -1 = unknown
+static const int8_t params[0x23] = {
+  -1, -1, -1, -1, -1, -1, -1,  1,  0,  4,  2,  2,  2,  0,  5,  0,   /* 0x00 */
+   0,  0,  0,  0,  0,  0,  0,  1,  0,  6,  0,  6,  0, -1, -1, -1,   /* 0x10 */
+   3,  2,  2                                                        /* 0x20 */
+};
+
+static IkbdPacket queue[IKBD_QUEUE_SIZE];
+static int        head, tail, size;
+static bool       paused;
+
+static uint8_t    cmd[IKBD_PACKET_MAX];
+static uint8_t    cmd_len;
+static uint8_t    skip;              // memory load data we swallow
+
+static uint8_t    mouse_mode;
+static uint8_t    button_action;
+static uint8_t    thresh_x, thresh_y;
+static uint8_t    scale_x, scale_y;
+static uint8_t    key_dx, key_dy;
+static bool       y_bottom;          // y = 0 at the bottom
+static uint16_t   max_x, max_y;
+static int32_t    abs_x, abs_y;
+static int32_t    acc_x, acc_y;      // motion not sent yet
+static uint8_t    buttons;           // bit 0 right, bit 1 left, like the packet
+static uint8_t    last_buttons;
+static uint8_t    abs_events;        // button transitions since the last interrogate
+
+static uint8_t    joy_mode;
+static uint8_t    joy[2];            // latest sample of both ports
+static uint8_t    last_joy[2];       // what the last events said
+
+static uint8_t    rtc[6];            // YY MM DD hh mm ss, binary
+static uint64_t   rtc_next;
+
+static void send_packet(const uint8_t *data, uint8_t len) {
+  if (size == IKBD_QUEUE_SIZE) {
+    if (debug)
+      printf("ikbd queue full\n");
+    return;
+  }
+  queue[tail].len = len;
+  memcpy(queue[tail].data, data, len);
+  tail = (tail + 1) % IKBD_QUEUE_SIZE;
+  size++;
+}
+
+static void send_byte(uint8_t data) {
+  send_packet(&data, 1);
+}
+
+HOTSPOT static uint8_t to_bcd(uint8_t v) {
+  return ((v / 10) << 4) | (v % 10);
+}
+
+HOTSPOT static uint8_t from_bcd(uint8_t v) {
+  return (v >> 4) * 10 + (v & 0x0F);
+}
+
+static void defaults(void) {
+  mouse_mode    = IKBD_MOUSE_REL;
+  button_action = 0;
+  thresh_x      = thresh_y = 1;
+  scale_x       = scale_y  = 1;
+  y_bottom      = false;
+  acc_x         = acc_y    = 0;
+  abs_events    = 0;
+  joy_mode      = IKBD_JOY_EVENT;
+  last_joy[0]   = joy[0];
+  last_joy[1]   = joy[1];
+  paused        = false;
+  head = tail = size = 0;
+}
+
+static void rtc_tick(void) {
+  static const uint8_t days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+  uint8_t mdays;
+
+  if (++rtc[5] < 60)
+    return;
+  rtc[5] = 0;
+  if (++rtc[4] < 60)
+    return;
+  rtc[4] = 0;
+  if (++rtc[3] < 24)
+    return;
+  rtc[3] = 0;
+  mdays = ((rtc[1] >= 1) && (rtc[1] <= 12)) ? days[rtc[1] - 1] : 31;
+  if ((rtc[1] == 2) && ((rtc[0] & 3) == 0))
+    mdays++;
+  if (++rtc[2] <= mdays)
+    return;
+  rtc[2] = 1;
+  if (++rtc[1] <= 12)
+    return;
+  rtc[1] = 1;
+  rtc[0] = (rtc[0] + 1) % 100;
+}
+
+static void interrogate_mouse(void) {
+  uint16_t y = y_bottom ? max_y - abs_y : abs_y;
+  uint8_t p[6] = { 0xF7, abs_events, abs_x >> 8, abs_x & 0xFF, y >> 8, y & 0xFF };
+
+  send_packet(p, sizeof(p));
+  abs_events = 0;
+}
+
+static void command(void) {
+  uint8_t p[7];
+  int i;
+
+  paused = false;
+  switch (cmd[0]) {
+  case 0x07:
+    button_action = cmd[1];
+    break;
+  case 0x08:
+    mouse_mode = IKBD_MOUSE_REL;
+    break;
+  case 0x09:
+    mouse_mode = IKBD_MOUSE_ABS;
+    max_x = (cmd[1] << 8) | cmd[2];
+    max_y = (cmd[3] << 8) | cmd[4];
+    abs_x = abs_y = 0;
+    break;
+  case 0x0A:
+    mouse_mode = IKBD_MOUSE_KEYCODE;
+    key_dx = cmd[1] ? cmd[1] : 1;
+    key_dy = cmd[2] ? cmd[2] : 1;
+    break;
+  case 0x0B:
+    thresh_x = cmd[1] ? cmd[1] : 1;
+    thresh_y = cmd[2] ? cmd[2] : 1;
+    break;
+  case 0x0C:
+    scale_x = cmd[1] ? cmd[1] : 1;
+    scale_y = cmd[2] ? cmd[2] : 1;
+    break;
+  case 0x0D:
+    interrogate_mouse();
+    break;
+  case 0x0E:
+    abs_x = (cmd[2] << 8) | cmd[3];
+    abs_y = (cmd[4] << 8) | cmd[5];
+    break;
+  case 0x0F:
+    y_bottom = true;
+    break;
+  case 0x10:
+    y_bottom = false;
+    break;
+  case 0x12:
+    mouse_mode = IKBD_MOUSE_OFF;
+    break;
+  case 0x13:
+    paused = true;
+    break;
+  case 0x14:
+    joy_mode = IKBD_JOY_EVENT;
+    break;
+  case 0x15:
+    joy_mode = IKBD_JOY_INTERROGATE;
+    break;
+  case 0x16:
+    p[0] = 0xFD;
+    p[1] = joy[0];
+    p[2] = joy[1];
+    send_packet(p, 3);
+    break;
+  case 0x1A:
+    joy_mode = IKBD_JOY_OFF;
+    break;
+  case 0x1B:
+    for (i = 0; i < 6; i++)
+      if (cmd[i + 1] != 0xFF)           // 0xFF leaves the field alone
+	rtc[i] = from_bcd(cmd[i + 1]);
+    rtc_next = time_us_64() + 1000000;
+    break;
+  case 0x1C:
+    p[0] = 0xFC;
+    for (i = 0; i < 6; i++)
+      p[i + 1] = to_bcd(rtc[i]);
+    send_packet(p, 7);
+    break;
+  case 0x20:
+    skip = cmd[3];
+    break;
+  case 0x80:
+    if (cmd[1] == 0x01) {
+      defaults();
+      send_byte(0xF1);
+    }
+    break;
+  default:
+    // 0x11 resume, monitoring modes, memory read / execute: nothing to do
+    break;
+  }
+}
+
+static void receive(uint8_t data) {
+  int8_t need;
+
+  if (skip) {
+    skip--;
+    return;
+  }
+  if (cmd_len == 0) {
+    if ((data != 0x80) && ((data >= sizeof(params)) || (params[data] < 0))) {
+      paused = false;
+      return;
+    }
+  }
+  cmd[cmd_len++] = data;
+  need = (cmd[0] == 0x80) ? 1 : params[cmd[0]];
+  if (cmd_len > need) {
+    command();
+    cmd_len = 0;
+  }
+}
+
+void ikbd_key_event(uint8_t keycode, bool pressed) {
+  uint8_t code = 0;
+
+  if (keycode >= 0xE0)
+    code = mod_st[keycode & 0x07];
+  else if (keycode < sizeof(to_st))
+    code = to_st[keycode];
+  if (code)
+    send_byte(pressed ? code : code | 0x80);
+}
+
+void ikbd_mouse(int16_t dx, int16_t dy, bool left, bool right) {
+  uint8_t b = (left ? 0x02 : 0) | (right ? 0x01 : 0);
+  uint8_t changed = b ^ buttons;
+
+  buttons = b;
+  if (button_action & 0x04) {
+    // buttons reported as keys 0x74 / 0x75
+    if (changed & 0x02)
+      send_byte(left ? 0x74 : 0xF4);
+    if (changed & 0x01)
+      send_byte(right ? 0x75 : 0xF5);
+    last_buttons = buttons;
+  }
+  switch (mouse_mode) {
+  case IKBD_MOUSE_ABS:
+    acc_x += dx;
+    acc_y += dy;
+    abs_x += acc_x / scale_x;
+    abs_y += acc_y / scale_y;
+    acc_x %= scale_x;
+    acc_y %= scale_y;
+    abs_x = (abs_x < 0) ? 0 : (abs_x > max_x) ? max_x : abs_x;
+    abs_y = (abs_y < 0) ? 0 : (abs_y > max_y) ? max_y : abs_y;
+    abs_events |= ((changed & b & 0x01) ? 0x01 : 0) | ((changed & ~b & 0x01) ? 0x02 : 0) |
+                  ((changed & b & 0x02) ? 0x04 : 0) | ((changed & ~b & 0x02) ? 0x08 : 0);
+    if (((button_action & 0x01) && (changed & b)) || ((button_action & 0x02) && (changed & ~b)))
+      interrogate_mouse();
+    break;
+  case IKBD_MOUSE_REL:
+  case IKBD_MOUSE_KEYCODE:
+    acc_x += dx;
+    acc_y += y_bottom ? -dy : dy;
+    break;
+  }
+}
+
+// refresh a port from the gamepad register of its player
+static void sample_joystick(uint8_t port, uint8_t player) {
+  static const uint8_t bits[9] = { 0x00, 0x01, 0x09, 0x08, 0x0A, 0x02, 0x06, 0x04, 0x05 };
+  GamepadState state;
+
+  if (!gamepad_read(player, &state, NULL))
+    return;
+  joy[port] = ((state.hat < 9) ? bits[state.hat] : 0) |
+              ((state.buttons & (GAMEPAD_A | GAMEPAD_B)) ? 0x80 : 0);
+}
+
+void ikbd_init(void) {
+  uart_init(IKBD_UART, IKBD_BAUD);
+  uart_set_format(IKBD_UART, 8, 1, UART_PARITY_NONE);
+  uart_set_hw_flow(IKBD_UART, false, false);
+  gpio_set_function(IKBD_TX_PIN, GPIO_FUNC_UART);
+  gpio_set_function(IKBD_RX_PIN, GPIO_FUNC_UART);
+  memset(rtc, 0, sizeof(rtc));
+  rtc_next = time_us_64() + 1000000;
+  joy[0]   = joy[1] = 0;
+  buttons  = last_buttons = 0;
+  cmd_len  = 0;
+  skip     = 0;
+  defaults();
+  send_byte(0xF1);
+}
+
+// link scheduler: a packet is only started once the previous one has
+// left the uart fifo, so packets never interleave. queued packets
+// (keys, replies) go first, then the joystick, then one mouse packet
+// built from all the motion accumulated meanwhile
+void ikbd_task(void) {
+  uint8_t p[3];
+  int used, dx, dy;
+
+  sample_joystick(0, IKBD_JOY0_PLAYER);
+  sample_joystick(1, IKBD_JOY1_PLAYER);
+  while (uart_is_readable(IKBD_UART))
+    receive(uart_getc(IKBD_UART));
+  if (time_us_64() >= rtc_next) {
+    rtc_next += 1000000;
+    rtc_tick();
+  }
+  if (paused || !(uart_get_hw(IKBD_UART)->fr & UART_UARTFR_TXFE_BITS))
+    return;
+  if (size) {
+    for (used = 0; size && (used + queue[head].len <= IKBD_UART_FIFO); ) {
+      uart_write_blocking(IKBD_UART, queue[head].data, queue[head].len);
+      used += queue[head].len;
+      head = (head + 1) % IKBD_QUEUE_SIZE;
+      size--;
+    }
+    return;
+  }
+  if ((joy_mode == IKBD_JOY_EVENT) && (joy[1] != last_joy[1])) {
+    p[0] = 0xFF;
+    p[1] = joy[1];
+    uart_write_blocking(IKBD_UART, p, 2);
+    last_joy[1] = joy[1];
+    return;
+  }
+  // port 0 is the mouse port, it only reports once the mouse is off
+  if ((joy_mode == IKBD_JOY_EVENT) && (mouse_mode == IKBD_MOUSE_OFF) && (joy[0] != last_joy[0])) {
+    p[0] = 0xFE;
+    p[1] = joy[0];
+    uart_write_blocking(IKBD_UART, p, 2);
+    last_joy[0] = joy[0];
+    return;
+  }
+  switch (mouse_mode) {
+  case IKBD_MOUSE_REL:
+    if ((abs(acc_x) < thresh_x) && (abs(acc_y) < thresh_y) &&
+	((button_action & 0x04) || (buttons == last_buttons)))
+      return;
+    dx = (acc_x < -128) ? -128 : (acc_x > 127) ? 127 : acc_x;
+    dy = (acc_y < -128) ? -128 : (acc_y > 127) ? 127 : acc_y;
+    acc_x -= dx;
+    acc_y -= dy;
+    p[0] = 0xF8 | ((button_action & 0x04) ? 0 : buttons);
+    p[1] = dx;
+    p[2] = dy;
+    uart_write_blocking(IKBD_UART, p, 3);
+    last_buttons = buttons;
+    break;
+  case IKBD_MOUSE_KEYCODE:
+    p[0] = 0;
+    if (acc_x >= key_dx) {
+      p[0] = 0x4D;
+      acc_x -= key_dx;
+    } else if (acc_x <= -key_dx) {
+      p[0] = 0x4B;
+      acc_x += key_dx;
+    } else if (acc_y >= key_dy) {
+      p[0] = 0x50;
+      acc_y -= key_dy;
+    } else if (acc_y <= -key_dy) {
+      p[0] = 0x48;
+      acc_y += key_dy;
+    }
+    if (p[0]) {
+      p[1] = p[0] | 0x80;
+      uart_write_blocking(IKBD_UART, p, 2);
+    }
+    break;
+  }
+}
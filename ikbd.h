@@ -0,0 +1,17 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#define IKBD_UART        uart1
+#define IKBD_TX_PIN      8
+#define IKBD_RX_PIN      9
+#define IKBD_BAUD        7812        // 7812.5 on the real thing, well within tolerance
+
+#define IKBD_QUEUE_SIZE  16
+#define IKBD_PACKET_MAX  8
+#define IKBD_JOY1_PLAYER 0          // gamepad register sampled for joystick 1
+#define IKBD_JOY0_PLAYER 1          // and for joystick 0, on the mouse port
+
+void ikbd_init(void);
+void ikbd_key_event(uint8_t, bool);
+void ikbd_mouse(int16_t, int16_t, bool, bool);
+void ikbd_task(void);
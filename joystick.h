@@ -0,0 +1,7 @@
+#define JOY_NONE      0     // gamepads are only printed on the console uart
+#define JOY_DB9       1     // Atari / Commodore / Amiga digital joystick
+#define JOY_KEYS      2     // gamepads type on the keyboard output, see keymap_profiles.c
+#define JOY_MOUSE     3     // an analog stick moves the mouse output
+#define JOY_GAMEPORT  4     // PC gameport, four analog axes and four buttons
+
+extern uint8_t joy_out;
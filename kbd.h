@@ -3,6 +3,14 @@
 
 #define TERM_TVI950 0
 #define TERM_VT100  1 
+#define TERM_XT     2
+#define TERM_AT     3
+#define TERM_C64    4
+#define TERM_ZX     5
+#define TERM_MSX    6
+#define TERM_IKBD   7
+#define TERM_AMIGA  8
+#define TERM_ADB    9
 
 #define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
 
@@ -62,6 +70,28 @@
 #define KBD_KEY_CAPSLOCK 0x39
 #define KBD_KEY_NUMLOCK  0x53
 
+// consumer and system control keys, past the modifiers where the
+// keyboard page has no usages
+#define KBD_KEY_MEDIA    0xE8       // the first of them
+#define KBD_KEY_PLAY     0xE8
+#define KBD_KEY_STOP     0xE9
+#define KBD_KEY_NEXT     0xEA
+#define KBD_KEY_PREV     0xEB
+#define KBD_KEY_MUTE     0xEC
+#define KBD_KEY_VOLUP    0xED
+#define KBD_KEY_VOLDN    0xEE
+#define KBD_KEY_CALC     0xEF
+#define KBD_KEY_MAIL     0xF0
+#define KBD_KEY_WWW      0xF1
+#define KBD_KEY_SEARCH   0xF2
+#define KBD_KEY_BACK     0xF3
+#define KBD_KEY_FORWARD  0xF4
+#define KBD_KEY_COMPUTER 0xF5
+#define KBD_KEY_POWER    0xF6
+#define KBD_KEY_SLEEP    0xF7
+#define KBD_KEY_WAKE     0xF8
+#define KBD_MEDIA_KEYS   17
+
 #define KEY_ENTER    0x8000
 #define KEY_UP       0x8001
 #define KEY_DOWN     0x8002
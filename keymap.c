@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "gamepad_state.h"
+#include "keymap.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+extern void process_mapped_key(uint8_t, uint8_t, bool);
+extern void process_mapped_repeat(uint8_t, uint8_t);
+extern bool debug;
+
+typedef struct {
+  const KeymapProfile *profile;
+  uint32_t inputs;                  // inputs held in the last update
+  uint32_t consumed;                // pressed into a combo, their release is silent
+  uint8_t  combos;                  // combos currently held
+} KeymapPlayer;
+
+static KeymapPlayer      players[GAMEPAD_PLAYERS];
+static const KeyBinding *repeat_key;
+static uint64_t          repeat_next;
+static const MacroKey   *macro;
+static uint64_t          macro_next;
+
+static void press(const KeymapProfile *profile, const KeyBinding *b) {
+  switch (b->type) {
+  case KEYMAP_KEY:
+    process_mapped_key(b->keycode, b->modifier, true);
+    // typematic like a keyboard: only the last key pressed repeats
+    repeat_key  = b->repeat ? b : NULL;
+    repeat_next = time_us_64() + KEYMAP_REPEAT_DELAY_US;
+    break;
+  case KEYMAP_MACRO:
+    if (!macro && profile->macros) {
+      macro      = profile->macros[b->keycode];
+      macro_next = time_us_64();
+    }
+    break;
+  }
+}
+
+static void release(const KeyBinding *b) {
+  if (b->type != KEYMAP_KEY)
+    return;
+  process_mapped_key(b->keycode, b->modifier, false);
+  if (repeat_key == b)
+    repeat_key = NULL;
+}
+
+void keymap_select(uint8_t player, uint16_t vid, uint16_t pid) {
+  int i;
+
+  for (i = 0; i < keymap_nprofiles; i++)
+    if (((keymap_profiles[i].vid == vid) && (keymap_profiles[i].pid == pid)) ||
+	((keymap_profiles[i].vid == 0) && (keymap_profiles[i].pid == 0)))
+      break;
+  if (i == keymap_nprofiles)
+    return;
+  players[player].profile  = &keymap_profiles[i];
+  players[player].inputs   = 0;
+  players[player].consumed = 0;
+  players[player].combos   = 0;
+  if (debug)
+    printf("player %d keymap %s\n", player, keymap_profiles[i].name);
+}
+
+// only the inputs that changed are looked at, each one is a table index
+void keymap_update(uint8_t player, uint8_t hat, uint16_t buttons) {
+  KeymapPlayer *p = &players[player];
+  const KeymapProfile *profile = p->profile;
+  uint32_t cur, changed;
+  int i;
+
+  if (!profile)
+    return;
+  cur = buttons | ((hat && (hat < 9)) ? KM_INPUT(KM_HAT_UP + hat - 1) : 0);
+  changed = cur ^ p->inputs;
+  if (!changed)
+    return;
+  for (i = 0; i < profile->ncombos; i++) {
+    uint32_t inputs = profile->combo[i].inputs;
+    bool held = ((cur & inputs) == inputs);
+
+    if (held && !(p->combos & (1 << i)) && (changed & inputs)) {
+      p->combos   |= 1 << i;
+      p->consumed |= changed & cur & inputs;
+      press(profile, &profile->combo[i].binding);
+    } else if (!held && (p->combos & (1 << i))) {
+      p->combos &= ~(1 << i);
+      release(&profile->combo[i].binding);
+    }
+  }
+  while (changed) {
+    uint32_t bit;
+
+    i = __builtin_ctz(changed);
+    bit = 1u << i;
+    changed &= changed - 1;
+    if (p->consumed & bit) {
+      if (!(cur & bit))
+	p->consumed &= ~bit;
+      continue;
+    }
+    if (cur & bit)
+      press(profile, &profile->input[i]);
+    else
+      release(&profile->input[i]);
+  }
+  p->inputs = cur;
+}
+
+// key repeat and macro typing, paced so the outputs never overflow
+void keymap_task(void) {
+  uint64_t now = time_us_64();
+
+  if (repeat_key && (now >= repeat_next)) {
+    process_mapped_repeat(repeat_key->keycode, repeat_key->modifier);
+    repeat_next += KEYMAP_REPEAT_US;
+  }
+  if (macro && (now >= macro_next)) {
+    if (macro->keycode) {
+      process_mapped_key(macro->keycode, macro->modifier, true);
+      process_mapped_key(macro->keycode, macro->modifier, false);
+      macro++;
+      macro_next = now + KEYMAP_MACRO_US;
+    } else
+      macro = NULL;
+  }
+}
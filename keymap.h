@@ -0,0 +1,70 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+// inputs: the GAMEPAD_* bit numbers, then the eight hat directions
+#define KM_BTN_RIGHT       0
+#define KM_BTN_LEFT        1
+#define KM_START           2
+#define KM_SELECT          3
+#define KM_Y               4
+#define KM_X               5
+#define KM_B               6
+#define KM_A               7
+#define KM_L2              8
+#define KM_R2              9
+#define KM_HOME            10
+#define KM_L3              11
+#define KM_R3              12
+#define KM_HAT_UP          16
+#define KM_HAT_UP_RIGHT    17
+#define KM_HAT_RIGHT       18
+#define KM_HAT_DOWN_RIGHT  19
+#define KM_HAT_DOWN        20
+#define KM_HAT_DOWN_LEFT   21
+#define KM_HAT_LEFT        22
+#define KM_HAT_UP_LEFT     23
+#define KEYMAP_INPUTS      24
+
+#define KM_INPUT(n)        (1u << (n))
+
+#define KEYMAP_NONE        0
+#define KEYMAP_KEY         1        // keycode with modifier, held as long as the input
+#define KEYMAP_MACRO       2        // keycode is the macro number, typed once
+
+#define KEYMAP_MAX_COMBOS       4
+#define KEYMAP_REPEAT_DELAY_US  500000
+#define KEYMAP_REPEAT_US        100000
+#define KEYMAP_MACRO_US         20000     // between two macro keys
+
+typedef struct {
+  uint8_t type;
+  uint8_t modifier;                 // USB modifier bits
+  uint8_t keycode;                  // USB usage, or macro number
+  bool    repeat;                   // typematic while held
+} KeyBinding;
+
+typedef struct {
+  uint32_t   inputs;                // all held: the binding replaces the last one pressed
+  KeyBinding binding;
+} KeyCombo;
+
+typedef struct {
+  uint8_t modifier;
+  uint8_t keycode;                  // 0 ends the macro
+} MacroKey;
+
+typedef struct {
+  const char      *name;
+  uint16_t         vid, pid;        // 0, 0 = used for any other gamepad
+  KeyBinding       input[KEYMAP_INPUTS];
+  uint8_t          ncombos;
+  KeyCombo         combo[KEYMAP_MAX_COMBOS];
+  const MacroKey *const *macros;
+} KeymapProfile;
+
+extern const KeymapProfile keymap_profiles[];
+extern const int           keymap_nprofiles;
+
+void keymap_select(uint8_t, uint16_t, uint16_t);
+void keymap_update(uint8_t, uint8_t, uint16_t);
+void keymap_task(void);
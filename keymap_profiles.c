@@ -0,0 +1,73 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "keymap.h"
+
+#define KEY(k)        { KEYMAP_KEY, 0x00, k, false }
+#define KEY_R(k)      { KEYMAP_KEY, 0x00, k, true }      // repeats while held
+#define SHIFT(k)      { KEYMAP_KEY, 0x02, k, false }
+#define CTRL(k)       { KEYMAP_KEY, 0x01, k, false }
+#define MACRO(n)      { KEYMAP_MACRO, 0x00, n, false }
+
+// nethack: #pray
+static const MacroKey pray[] = {
+  { 0x02, 0x20 }, { 0x00, 0x13 }, { 0x00, 0x15 }, { 0x00, 0x04 }, { 0x00, 0x1C }, { 0x00, 0x28 }, { 0, 0 }
+};
+
+static const MacroKey *const nethack_macros[] = { pray };
+
+const KeymapProfile keymap_profiles[] = {
+  {
+    // roguelikes: vi keys on the pad, SELECT is the combo shift
+    "nethack", 0x081f, 0xe401,
+    {
+      [KM_HAT_UP]         = KEY_R(0x0E),   /* k */
+      [KM_HAT_UP_RIGHT]   = KEY_R(0x18),   /* u */
+      [KM_HAT_RIGHT]      = KEY_R(0x0F),   /* l */
+      [KM_HAT_DOWN_RIGHT] = KEY_R(0x11),   /* n */
+      [KM_HAT_DOWN]       = KEY_R(0x0D),   /* j */
+      [KM_HAT_DOWN_LEFT]  = KEY_R(0x05),   /* b */
+      [KM_HAT_LEFT]       = KEY_R(0x0B),   /* h */
+      [KM_HAT_UP_LEFT]    = KEY_R(0x1C),   /* y */
+      [KM_A]              = KEY_R(0x16),   /* s, search */
+      [KM_B]              = KEY(0x29),     /* ESC */
+      [KM_X]              = KEY(0x0C),     /* i, inventory */
+      [KM_Y]              = KEY(0x36),     /* , pick up */
+      [KM_START]          = KEY(0x28),     /* ENTER */
+      [KM_BTN_LEFT]       = SHIFT(0x36),   /* < */
+      [KM_BTN_RIGHT]      = SHIFT(0x37),   /* > */
+    },
+    3, {
+      { KM_INPUT(KM_SELECT) | KM_INPUT(KM_START), MACRO(0) },
+      { KM_INPUT(KM_SELECT) | KM_INPUT(KM_A),     KEY(0x08) },       /* e, eat */
+      { KM_INPUT(KM_SELECT) | KM_INPUT(KM_B),     SHIFT(0x1E) }      /* ! */
+    },
+    nethack_macros
+  },
+  {
+    // anything else: cursor keys, the diagonals on the keypad block
+    "cursor keys", 0, 0,
+    {
+      [KM_HAT_UP]         = KEY_R(0x52),
+      [KM_HAT_UP_RIGHT]   = KEY_R(0x4B),   /* PGUP */
+      [KM_HAT_RIGHT]      = KEY_R(0x4F),
+      [KM_HAT_DOWN_RIGHT] = KEY_R(0x4E),   /* PGDN */
+      [KM_HAT_DOWN]       = KEY_R(0x51),
+      [KM_HAT_DOWN_LEFT]  = KEY_R(0x4D),   /* END */
+      [KM_HAT_LEFT]       = KEY_R(0x50),
+      [KM_HAT_UP_LEFT]    = KEY_R(0x4A),   /* HOME */
+      [KM_A]              = KEY(0x28),     /* ENTER */
+      [KM_B]              = KEY(0x29),     /* ESC */
+      [KM_X]              = KEY_R(0x2C),   /* SPACE */
+      [KM_Y]              = KEY(0x2B),     /* TAB */
+      [KM_BTN_LEFT]       = KEY_R(0x2A),   /* BS */
+      [KM_BTN_RIGHT]      = KEY_R(0x4C),   /* DEL */
+    },
+    2, {
+      { KM_INPUT(KM_SELECT) | KM_INPUT(KM_START), CTRL(0x06) },      /* ^C */
+      { KM_INPUT(KM_SELECT) | KM_INPUT(KM_B),     CTRL(0x1D) }       /* ^Z */
+    },
+    0
+  }
+};
+
+const int keymap_nprofiles = sizeof(keymap_profiles) / sizeof(keymap_profiles[0]);
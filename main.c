@@ -8,6 +8,27 @@
 #include "kbd_ringbuffer.h"
 #include "mouse_ringbuffer.h"
 #include "kbd.h"
+#include "ps2_kbd.h"
+#include "matrix.h"
+#include "ikbd.h"
+#include "amiga_kbd.h"
+#include "adb.h"
+#include "mouse.h"
+#include "mouse_accel.h"
+#include "term_mouse.h"
+#include "ps2_mouse.h"
+#include "quadrature.h"
+#include "c1351.h"
+#include "tablet.h"
+#include "joystick.h"
+#include "db9.h"
+#include "gamepad_state.h"
+#include "keymap.h"
+#include "stick_mouse.h"
+#include "gameport.h"
+#include "hid_desc.h"
+#include "hid_pointer.h"
+#include "hid_merge.h"
 
 bool debug = false;
 bool hid_debug = true;
@@ -15,10 +36,15 @@ KbdRingBuffer *krb = NULL;
 MouseRingBuffer *mrb = NULL;
 uint8_t lang  = LANG_EN;
 uint8_t term  = TERM_TVI950;
+uint8_t mouse_out = MOUSE_SERIAL;
+uint8_t joy_out   = JOY_NONE;
+uint8_t tmouse_mode = TMOUSE_OFF;   // MOUSE_SERIAL: report the mouse on the terminal stream
+bool    tmouse_sgr  = false;
 
 int kbd_decode_vt100(KbdRingBuffer *, uint8_t, uint8_t);
 int kbd_decode_tvi950(KbdRingBuffer *, uint8_t, uint8_t);
-int mouse_decode(MouseRingBuffer *, int8_t, int8_t, int8_t, bool, bool, bool);
+int mouse_decode(MouseRingBuffer *, const MouseEvent *);
+void hid_task(void);
 
 void  dump(uint8_t *buffer, size_t size) {
   uint32_t i, a, lsize;
@@ -59,16 +85,129 @@ void process_keycode(int keycode, int modifier) {
   }
 }
 
-void process_nintendo_gamepad(uint8_t joystick, uint8_t buttons) {
-  printf("joystick = '%d', buttons '%0.2x'\n", joystick, buttons);
+void process_key_event(uint8_t keycode, bool pressed) {
+  switch(term) {
+  case TERM_XT:
+  case TERM_AT:
+    ps2_kbd_key_event(keycode, pressed);
+    break;
+  case TERM_C64:
+  case TERM_ZX:
+  case TERM_MSX:
+    matrix_key_event(keycode, pressed);
+    break;
+  case TERM_IKBD:
+    ikbd_key_event(keycode, pressed);
+    break;
+  case TERM_AMIGA:
+    amiga_kbd_key_event(keycode, pressed);
+    break;
+  case TERM_ADB:
+    adb_key_event(keycode, pressed);
+    break;
+  }
 }
 
-void process_mini_gamepad(uint8_t joystick, uint8_t buttons) {
-  printf("joystick = '%d', buttons '%0.2x'\n", joystick, buttons);  
+// consumer and system control keys: only the PC keyboard has codes for them
+void process_media_key(uint8_t keycode, bool pressed) {
+  if ((term == TERM_XT) || (term == TERM_AT))
+    ps2_kbd_key_event(keycode, pressed);
+  else if (debug)
+    printf("media key %0.2x %s\n", keycode, pressed ? "pressed" : "released");
 }
 
-void process_mouse(int8_t dx, int8_t dy, int8_t dw, bool left, bool right, bool middle) {
-  mouse_decode(mrb, dx, dy, dw, left, right, middle);
+// keys typed by the gamepad, through the same paths as the USB keyboard
+void process_mapped_key(uint8_t keycode, uint8_t modifier, bool pressed) {
+  int i;
+
+  if (pressed) {
+    for (i = 0; i < 8; i++)
+      if (modifier & (1 << i))
+	process_key_event(0xE0 + i, true);
+    process_key_event(keycode, true);
+    process_keycode(keycode, modifier);
+  } else {
+    process_key_event(keycode, false);
+    for (i = 0; i < 8; i++)
+      if (modifier & (1 << i))
+	process_key_event(0xE0 + i, false);
+  }
+}
+
+// keyboard devices repeat held keys on their own, terminals do not
+void process_mapped_repeat(uint8_t keycode, uint8_t modifier) {
+  process_keycode(keycode, modifier);
+}
+
+void process_gamepad_mount(uint8_t player, uint16_t vid, uint16_t pid) {
+  if (joy_out == JOY_KEYS)
+    keymap_select(player, vid, pid);
+}
+
+// every changed gamepad report, already normalized and published
+void process_gamepad(uint8_t player, const GamepadState *state) {
+  if (joy_out == JOY_DB9) {
+    db9_update(state->hat, state->buttons & 0xFF);
+    return;
+  }
+  if (joy_out == JOY_KEYS) {
+    keymap_update(player, state->hat, state->buttons);
+    return;
+  }
+  if (joy_out == JOY_GAMEPORT) {
+    if (player == GAMEPORT_PLAYER)
+      gameport_update(state);
+    return;
+  }
+  // the stick mouse samples the register at its own pace
+  if ((joy_out == JOY_MOUSE) || (term == TERM_IKBD))
+    return;
+  printf("player %d: hat = '%d', buttons '%0.4x', axes %d %d %d %d\n", player, state->hat, state->buttons,
+	 state->axis[0], state->axis[1], state->axis[2], state->axis[3]);
+}
+
+void process_mouse(int16_t dx, int16_t dy, int8_t dw, int8_t pan, uint8_t buttons) {
+  MouseEvent event = { dx, dy, dw, pan, buttons };
+
+  mouse_decode(mrb, &event);
+}
+
+// absolute pointers, 0..65535 across the range: the outputs that take
+// positions get them, the others the deltas at HID_POINTER_SPAN counts
+void process_pointer(uint16_t x, uint16_t y, bool prox, uint8_t buttons, int8_t wheel) {
+  static uint16_t last_x, last_y;
+  static int32_t  rem_x, rem_y;
+  static bool     tracking = false;
+  int32_t dx, dy;
+
+  if ((mouse_out == MOUSE_TABLET_MM) || (mouse_out == MOUSE_TABLET_WACOM)) {
+    tablet_absolute(x, y, 65535, 65535, prox, buttons);
+    return;
+  }
+  if ((mouse_out == MOUSE_SERIAL) && (tmouse_mode != TMOUSE_OFF) && (term != TERM_IKBD) && (term != TERM_ADB)) {
+    // a lift often comes as one report out of range: release in place,
+    // its position is not worth anything
+    if (prox)
+      term_mouse_absolute(x, y, wheel, buttons);
+    else
+      term_mouse_move(0, 0, 0, 0);
+    return;
+  }
+  // coming into range only places the pointer
+  if (!prox || !tracking) {
+    rem_x = rem_y = 0;
+  } else {
+    rem_x += ((int32_t) x - last_x) * HID_POINTER_SPAN;
+    rem_y += ((int32_t) y - last_y) * HID_POINTER_SPAN;
+  }
+  dx = rem_x / 65536;
+  dy = rem_y / 65536;
+  rem_x -= dx * 65536;
+  rem_y -= dy * 65536;
+  tracking = prox;
+  last_x   = x;
+  last_y   = y;
+  process_mouse(dx, dy, wheel, 0, prox ? buttons : 0);
 }
 
 bool led_service (repeating_timer_t *rt) {
@@ -99,36 +238,151 @@ int main (void) {
   printf("program stated\n");
   board_init();
   tusb_init();
+  // the keyboard matrix takes GP2..GP17, the pins of every mouse and
+  // joystick port: the mouse falls back to the console uart
+  if (((term == TERM_C64) || (term == TERM_ZX) || (term == TERM_MSX)) &&
+      ((mouse_out != MOUSE_SERIAL) || (joy_out == JOY_DB9) || (joy_out == JOY_GAMEPORT))) {
+    printf("keyboard matrix on GP2..GP17: mouse output %d and joystick output %d not started\n", mouse_out, joy_out);
+    mouse_out = MOUSE_SERIAL;
+    if ((joy_out == JOY_DB9) || (joy_out == JOY_GAMEPORT))
+      joy_out = JOY_NONE;
+  }
+  // the IKBD link is uart1 on GP8 / GP9, inside the DB9 port pins, and
+  // the tablets would move uart1 to GP4 / GP5. mouse and joystick go
+  // over the link anyway
+  if ((term == TERM_IKBD) && ((mouse_out == MOUSE_AMIGA) || (mouse_out == MOUSE_ATARI) ||
+			      (mouse_out == MOUSE_C1351) || (mouse_out == MOUSE_C1351N) ||
+			      (mouse_out == MOUSE_TABLET_MM) || (mouse_out == MOUSE_TABLET_WACOM) || (joy_out == JOY_DB9))) {
+    printf("IKBD on GP8 / GP9: mouse output %d and joystick output %d not started\n", mouse_out, joy_out);
+    mouse_out = MOUSE_SERIAL;
+    if (joy_out == JOY_DB9)
+      joy_out = JOY_NONE;
+  }
+  if ((term == TERM_XT) || (term == TERM_AT))
+    ps2_kbd_init(term == TERM_XT);
+  if (term == TERM_C64)
+    matrix_init(&matrix_c64);
+  if (term == TERM_ZX)
+    matrix_init(&matrix_zx);
+  if (term == TERM_MSX)
+    matrix_init(&matrix_msx);
+  if (term == TERM_IKBD)
+    ikbd_init();
+  if (term == TERM_AMIGA)
+    amiga_kbd_init();
+  if (term == TERM_ADB)
+    adb_init();
+  // the ADB mouse takes the USB mouse, and pio0 sm1 with it
+  if ((mouse_out == MOUSE_PS2) && (term != TERM_ADB))
+    ps2_mouse_init();
+  if ((mouse_out == MOUSE_AMIGA) || (mouse_out == MOUSE_ATARI))
+    quad_init((mouse_out == MOUSE_AMIGA) ? QUAD_AMIGA : QUAD_ATARI_ST);
+  if ((mouse_out == MOUSE_C1351) || (mouse_out == MOUSE_C1351N))
+    c1351_init(mouse_out == MOUSE_C1351N);
+  if ((mouse_out == MOUSE_TABLET_MM) || (mouse_out == MOUSE_TABLET_WACOM))
+    tablet_init((mouse_out == MOUSE_TABLET_MM) ? TABLET_MM : TABLET_WACOM_IV);
+  if ((mouse_out == MOUSE_SERIAL) && (tmouse_mode != TMOUSE_OFF))
+    term_mouse_init();
+  // one DB9 port on GP6..: the mouse has it when both are set
+  if ((joy_out == JOY_DB9) && (mouse_out != MOUSE_AMIGA) && (mouse_out != MOUSE_ATARI) &&
+      (mouse_out != MOUSE_C1351) && (mouse_out != MOUSE_C1351N))
+    db9_init(&db9_default);
+  if (joy_out == JOY_MOUSE)
+    stick_mouse_init();
+  // both need most of pio1
+  if ((joy_out == JOY_GAMEPORT) && (mouse_out != MOUSE_C1351) && (mouse_out != MOUSE_C1351N))
+    gameport_init(&gameport_default);
+  mouse_accel_init(&mouse_profiles[((term == TERM_IKBD) || (term == TERM_ADB)) ? MOUSE_PROFILE_LINK : mouse_out]);
   add_repeating_timer_ms(1000/2, led_service, NULL, &timer_led);
   while (1) {
-    int8_t x, y, wheel;
+    MouseEvent event;
+    int16_t x, y;
     bool left, right, middle;
     uint16_t key;
     
     tuh_task();
+    hid_task();
+    hid_merge_task();
+    if ((term == TERM_XT) || (term == TERM_AT))
+      ps2_kbd_task();
+    if ((term == TERM_C64) || (term == TERM_ZX) || (term == TERM_MSX))
+      matrix_task();
+    if (term == TERM_IKBD)
+      ikbd_task();
+    if (term == TERM_AMIGA)
+      amiga_kbd_task();
+    if (term == TERM_ADB)
+      adb_task();
+    if ((mouse_out == MOUSE_PS2) && (term != TERM_ADB))
+      ps2_mouse_task();
+    if ((mouse_out == MOUSE_C1351) || (mouse_out == MOUSE_C1351N))
+      c1351_task();
+    if (joy_out == JOY_KEYS)
+      keymap_task();
+    if (joy_out == JOY_MOUSE)
+      stick_mouse_task(mrb);
+    mouse_accel_task(mrb);
+    if ((mouse_out == MOUSE_SERIAL) && (tmouse_mode != TMOUSE_OFF))
+      term_mouse_task(krb);
     while(KbdGetKey(krb, &key)) {
       if (debug) {
       	printf("key = %x\n", key);
       } else
       	printf("%c", key);
     }
-    while(MouseGetEvent(mrb, &x, &y, &wheel, &left, &right, &middle)) {
+    while(MouseGetEvent(mrb, &event)) {
+      mouse_accel(&event);
+      x      = event.delta_x;
+      y      = event.delta_y;
+      left   = event.buttons & MOUSE_BTN_LEFT;
+      right  = event.buttons & MOUSE_BTN_RIGHT;
+      middle = event.buttons & MOUSE_BTN_MIDDLE;
+      // the IKBD carries keyboard, mouse and joystick on one link
+      if (term == TERM_IKBD) {
+	ikbd_mouse(x, y, left, right);
+	continue;
+      }
+      if (term == TERM_ADB) {
+	adb_mouse(x, y, left, right);
+	continue;
+      }
+      switch (mouse_out) {
+      case MOUSE_PS2:
+	ps2_mouse_move(x, y, event.delta_wheel, event.buttons);
+	continue;
+      case MOUSE_AMIGA:
+      case MOUSE_ATARI:
+	quad_move(x, y, left, right, middle);
+	continue;
+      case MOUSE_C1351:
+      case MOUSE_C1351N:
+	c1351_move(x, y, left, right);
+	continue;
+      case MOUSE_TABLET_MM:
+      case MOUSE_TABLET_WACOM:
+	tablet_move(x, y, event.buttons);
+	continue;
+      }
+      if (tmouse_mode != TMOUSE_OFF) {
+	term_mouse_move(x, y, event.delta_wheel, event.buttons);
+	continue;
+      }
    //   printf("x = %d, y = %d, wheel = %d, left = %d, right = %d, middle = %d\n", x, y, wheel, left, right, middle);
-      pos_x     = pos_x     + (int16_t) x;
+      pos_x     = pos_x     + x;
       if (pos_x < 0) 
 	pos_x = 0; 
       if (pos_x >= 1024)
 	pos_x = 1023;
-      pos_y     = pos_y     + (int16_t) y;
+      pos_y     = pos_y     + y;
       if (pos_y < 0) 
 	pos_y = 0; 
       if (pos_y >= 768)
 	pos_y = 767;
-      pos_wheel = pos_wheel + (int16_t) wheel;      
+      pos_wheel = pos_wheel + event.delta_wheel;      
       if (pos_wheel < 0) 
 	pos_wheel = 0; 
       if (pos_wheel >= 256)
-	pos_y = 255;
+	pos_wheel = 255;
       printf("position: %d %d, wheel = %d\n", pos_x, pos_y, pos_wheel);
     }
   }
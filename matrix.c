@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/gpio.h"
+#include "hardware/structs/sio.h"
+#include "hardware/sync.h"
+#include "matrix.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+#define MATRIX_COL_MASK  (0xFF << MATRIX_COL_BASE)
+#define MATRIX_HELD      8
+
+extern bool debug;
+
+typedef struct {
+  uint8_t  keycode;
+  uint16_t entry;                   // map entry chosen when the key went down
+  uint64_t visible;                 // the key shows up in the matrix from then on
+} MatrixKey;
+
+static const MatrixMachine *machine;
+
+// column masks for every possible state of the row lines, the
+// host side core only ever reads the one live points to. the pointer
+// itself is volatile too, or core 1 may keep it in a register
+static uint8_t           table[2][256];
+static volatile uint8_t *volatile live;
+static uint32_t          row_mask;
+static uint32_t          row_xor;
+
+static MatrixKey held[MATRIX_HELD];
+static int       nheld;
+static uint8_t   mods;              // USB modifier keys currently down
+static uint16_t  linger;            // shift override kept after a release
+static uint64_t  linger_until;
+static bool      shift_state;       // what the target currently sees
+static bool      symbol_state;
+static uint64_t  next_publish;      // a delayed change is due then
+
+// core 1: nothing but row lines in, column lines out
+static void __not_in_flash_func(matrix_scan)(void) {
+  while (true) {
+    uint32_t rows = ((sio_hw->gpio_in >> MATRIX_ROW_BASE) ^ row_xor) & row_mask;
+    uint32_t cols = (uint32_t) live[rows] << MATRIX_COL_BASE;
+
+    sio_hw->gpio_oe_togl = (sio_hw->gpio_oe ^ cols) & MATRIX_COL_MASK;
+  }
+}
+
+HOTSPOT static void set_key(uint8_t *rows, uint8_t pos) {
+  rows[pos >> 3] |= 1 << (pos & 0x07);
+}
+
+// rebuild the row bitmaps, expand them into the spare table and swap
+static void publish(uint64_t now) {
+  uint8_t  rows[MATRIX_ROWS] = { 0 };
+  uint8_t *spare;
+  uint16_t flags = 0;
+  bool     shift = false, symbol = false;
+  int      i;
+
+  for (i = 0; i < 8; i++) {
+    uint16_t m = machine->mods[i];
+
+    if (!(mods & (1 << i)) || !m)
+      continue;
+    if (MX_POS(m) == machine->shift)
+      shift = true;
+    else if (MX_POS(m) == machine->symbol)
+      symbol = true;
+    else
+      set_key(rows, MX_POS(m));
+  }
+  next_publish = (now < linger_until) ? linger_until : 0;
+  for (i = 0; i < nheld; i++) {
+    if (held[i].visible <= now)
+      set_key(rows, MX_POS(held[i].entry));
+    else if (!next_publish || (held[i].visible < next_publish))
+      next_publish = held[i].visible;
+    if (held[i].entry & MX_FLAGS)
+      flags = held[i].entry & MX_FLAGS;
+  }
+  if (!flags && (now < linger_until))
+    flags = linger;
+  switch (flags) {
+  case MX_SHIFT:
+    shift = true;
+    symbol = false;
+    break;
+  case MX_SYM:
+    shift = false;
+    symbol = true;
+    break;
+  case MX_PLAIN:
+    shift = false;
+    symbol = false;
+    break;
+  }
+  if (shift)
+    set_key(rows, machine->shift);
+  if (symbol && (machine->symbol != 0xFF))
+    set_key(rows, machine->symbol);
+  shift_state  = shift;
+  symbol_state = symbol;
+
+  spare = (live == table[0]) ? table[1] : table[0];
+  spare[0] = 0;
+  if (machine->select == MATRIX_BINARY) {
+    for (i = 0; i < 256; i++)
+      spare[i] = rows[i & (MATRIX_ROWS - 1)];
+  } else {
+    // several rows strobed at once read the OR of their columns
+    for (i = 1; i < 256; i++)
+      spare[i] = spare[i & (i - 1)] | rows[__builtin_ctz(i)];
+  }
+  // the table is complete in memory before core 1 can see the pointer
+  __dmb();
+  live = spare;
+}
+
+// shift state the target has to see for this entry
+static bool needs_change(uint16_t entry) {
+  switch (entry & MX_FLAGS) {
+  case MX_SHIFT:
+    return !shift_state || symbol_state;
+  case MX_SYM:
+    return shift_state || !symbol_state;
+  case MX_PLAIN:
+    return shift_state || symbol_state;
+  }
+  return false;
+}
+
+void matrix_key_event(uint8_t keycode, bool pressed) {
+  uint64_t now = time_us_64();
+  uint16_t entry;
+  int i;
+
+  if (keycode >= 0xE0) {
+    if (pressed)
+      mods |= 1 << (keycode & 0x07);
+    else
+      mods &= ~(1 << (keycode & 0x07));
+    publish(now);
+    return;
+  }
+  if (!pressed) {
+    for (i = 0; i < nheld; i++)
+      if (held[i].keycode == keycode) {
+	// keep the shift override a little so the release is read with it
+	if (held[i].entry & MX_FLAGS) {
+	  linger       = held[i].entry & MX_FLAGS;
+	  linger_until = now + MATRIX_SETTLE_US;
+	}
+	held[i] = held[--nheld];
+	break;
+      }
+    publish(now);
+    return;
+  }
+  if ((keycode >= sizeof(machine->map) / sizeof(machine->map[0])) || (nheld == MATRIX_HELD))
+    return;
+  entry = machine->map[keycode][(mods & 0x22) ? 1 : 0];
+  if (!entry)
+    return;
+  held[nheld].keycode = keycode;
+  held[nheld].entry   = entry;
+  // the target must have scanned the new shift state before the key
+  held[nheld].visible = needs_change(entry) ? now + MATRIX_SETTLE_US : now;
+  nheld++;
+  publish(now);
+}
+
+void matrix_init(const MatrixMachine *m) {
+  int i;
+
+  machine  = m;
+  nheld    = 0;
+  mods     = 0;
+  linger   = 0;
+  linger_until = 0;
+  row_mask = (1 << m->row_lines) - 1;
+  row_xor  = (m->select == MATRIX_ONE_HOT) ? row_mask : 0;   // strobes are active low
+  live     = table[0];
+  publish(time_us_64());
+  for (i = 0; i < 8; i++) {
+    gpio_init(MATRIX_ROW_BASE + i);
+    gpio_set_dir(MATRIX_ROW_BASE + i, GPIO_IN);
+    gpio_init(MATRIX_COL_BASE + i);
+    gpio_put(MATRIX_COL_BASE + i, false);
+    gpio_set_dir(MATRIX_COL_BASE + i, GPIO_IN);
+  }
+  if (debug)
+    printf("%s keyboard matrix\n", m->name);
+  multicore_launch_core1(matrix_scan);
+}
+
+// apply delayed key presses and expired shift overrides
+void matrix_task(void) {
+  uint64_t now = time_us_64();
+
+  if (next_publish && (now >= next_publish))
+    publish(now);
+}
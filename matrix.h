@@ -0,0 +1,36 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MATRIX_ROW_BASE    2        // GP2..GP9, row strobes from the host
+#define MATRIX_COL_BASE    10       // GP10..GP17, columns, open collector
+#define MATRIX_ROWS        16
+#define MATRIX_SETTLE_US   20000    // longer than one keyboard scan of the target
+
+// map entries: row / column plus what the machine shift keys must do
+#define MX(row, col)       (0x8000 | ((row) << 3) | (col))
+#define MX_SHIFT           0x0100   // primary shift held, symbol shift released
+#define MX_SYM             0x0200   // symbol shift held, primary shift released
+#define MX_PLAIN           0x0300   // both released
+#define MX_FLAGS           0x0300
+#define MX_POS(m)          ((m) & 0x7F)
+
+#define MATRIX_ONE_HOT     0        // a row is selected by pulling its line low
+#define MATRIX_BINARY      1        // the row number is put on the lines
+
+typedef struct {
+  const char *name;
+  uint8_t     select;               // MATRIX_ONE_HOT / MATRIX_BINARY
+  uint8_t     row_lines;            // number of row strobe inputs
+  uint8_t     shift;                // matrix position of the primary shift
+  uint8_t     symbol;               // secondary shift, 0xFF if none
+  uint16_t    mods[8];              // USB modifiers 0xE0..0xE7
+  uint16_t    map[0x65][2];         // USB usage, without and with shift
+} MatrixMachine;
+
+extern const MatrixMachine matrix_c64;
+extern const MatrixMachine matrix_zx;
+extern const MatrixMachine matrix_msx;
+
+void matrix_init(const MatrixMachine *);
+void matrix_key_event(uint8_t, bool);
+void matrix_task(void);
@@ -0,0 +1,167 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+
+// same matrix key with and without shift, the target sees the user's shift
+#define K(row, col)   { MX(row, col), MX(row, col) }
+
+/*
+ * Commodore 64: rows are CIA1 port A (driven low by the host),
+ * columns are port B.
+ *
+ *        PB0    PB1    PB2    PB3    PB4    PB5    PB6    PB7
+ *  PA0   DEL    RET    RIGHT  F7     F1     F3     F5     DOWN
+ *  PA1   3      W      A      4      Z      S      E      LSHIFT
+ *  PA2   5      R      D      6      C      F      T      X
+ *  PA3   7      Y      G      8      B      H      U      V
+ *  PA4   9      I      J      0      M      K      O      N
+ *  PA5   +      P      L      -      .      :      @      ,
+ *  PA6   POUND  *      ;      HOME   RSHIFT =      UP     /
+ *  PA7   1      LEFT   CTRL   2      SPACE  C=     Q      STOP
+ */
+const MatrixMachine matrix_c64 = {
+  "c64", MATRIX_ONE_HOT, 8, MX_POS(MX(1, 7)), 0xFF,
+  { MX(7, 2), MX(1, 7), MX(7, 5), MX(7, 5), MX(7, 2), MX(1, 7), MX(7, 5), MX(7, 5) },
+  {
+    [0x04] = K(1, 2), [0x05] = K(3, 4), [0x06] = K(2, 4), [0x07] = K(2, 2),
+    [0x08] = K(1, 6), [0x09] = K(2, 5), [0x0A] = K(3, 2), [0x0B] = K(3, 5),
+    [0x0C] = K(4, 1), [0x0D] = K(4, 2), [0x0E] = K(4, 5), [0x0F] = K(5, 2),
+    [0x10] = K(4, 4), [0x11] = K(4, 7), [0x12] = K(4, 6), [0x13] = K(5, 1),
+    [0x14] = K(7, 6), [0x15] = K(2, 1), [0x16] = K(1, 5), [0x17] = K(2, 6),
+    [0x18] = K(3, 6), [0x19] = K(3, 7), [0x1A] = K(1, 1), [0x1B] = K(2, 7),
+    [0x1C] = K(3, 1), [0x1D] = K(1, 4),
+    [0x1E] = K(7, 0),                                           /* 1 !      */
+    [0x1F] = { MX(7, 3), MX(5, 6) | MX_PLAIN },                 /* 2 @      */
+    [0x20] = K(1, 0), [0x21] = K(1, 3), [0x22] = K(2, 0),       /* 3 4 5    */
+    [0x23] = { MX(2, 3), MX(6, 6) | MX_PLAIN },                 /* 6 ^      */
+    [0x24] = { MX(3, 0), MX(2, 3) | MX_SHIFT },                 /* 7 &      */
+    [0x25] = { MX(3, 3), MX(6, 1) | MX_PLAIN },                 /* 8 *      */
+    [0x26] = { MX(4, 0), MX(3, 3) | MX_SHIFT },                 /* 9 (      */
+    [0x27] = { MX(4, 3), MX(4, 0) | MX_SHIFT },                 /* 0 )      */
+    [0x28] = K(0, 1),                                           /* RETURN   */
+    [0x29] = K(7, 7),                                           /* RUN/STOP */
+    [0x2A] = K(0, 0),                                           /* DEL      */
+    [0x2C] = K(7, 4),                                           /* SPACE    */
+    [0x2D] = { MX(5, 3), MX(7, 1) | MX_PLAIN },                 /* - _      */
+    [0x2E] = { MX(6, 5) | MX_PLAIN, MX(5, 0) | MX_PLAIN },      /* = +      */
+    [0x2F] = { MX(5, 5) | MX_SHIFT, MX(5, 5) | MX_SHIFT },      /* [ {      */
+    [0x30] = { MX(6, 2) | MX_SHIFT, MX(6, 2) | MX_SHIFT },      /* ] }      */
+    [0x31] = { MX(6, 0) | MX_PLAIN, MX(6, 0) | MX_PLAIN },      /* \ |      */
+    [0x33] = { MX(6, 2) | MX_PLAIN, MX(5, 5) | MX_PLAIN },      /* ; :      */
+    [0x34] = { MX(3, 0) | MX_SHIFT, MX(7, 3) | MX_SHIFT },      /* ' "      */
+    [0x35] = { MX(7, 1) | MX_PLAIN, MX(7, 1) | MX_PLAIN },      /* ` ~      */
+    [0x36] = K(5, 7), [0x37] = K(5, 4), [0x38] = K(6, 7),       /* , . /    */
+    [0x3A] = { MX(0, 4) | MX_PLAIN, MX(0, 4) | MX_PLAIN },      /* F1       */
+    [0x3B] = { MX(0, 4) | MX_SHIFT, MX(0, 4) | MX_SHIFT },      /* F2       */
+    [0x3C] = { MX(0, 5) | MX_PLAIN, MX(0, 5) | MX_PLAIN },      /* F3       */
+    [0x3D] = { MX(0, 5) | MX_SHIFT, MX(0, 5) | MX_SHIFT },      /* F4       */
+    [0x3E] = { MX(0, 6) | MX_PLAIN, MX(0, 6) | MX_PLAIN },      /* F5       */
+    [0x3F] = { MX(0, 6) | MX_SHIFT, MX(0, 6) | MX_SHIFT },      /* F6       */
+    [0x40] = { MX(0, 3) | MX_PLAIN, MX(0, 3) | MX_PLAIN },      /* F7       */
+    [0x41] = { MX(0, 3) | MX_SHIFT, MX(0, 3) | MX_SHIFT },      /* F8       */
+    [0x49] = { MX(0, 0) | MX_SHIFT, MX(0, 0) | MX_SHIFT },      /* INST     */
+    [0x4A] = K(6, 3),                                           /* HOME     */
+    [0x4C] = K(0, 0),                                           /* DEL      */
+    [0x4F] = { MX(0, 2) | MX_PLAIN, MX(0, 2) | MX_PLAIN },      /* RIGHT    */
+    [0x50] = { MX(0, 2) | MX_SHIFT, MX(0, 2) | MX_SHIFT },      /* LEFT     */
+    [0x51] = { MX(0, 7) | MX_PLAIN, MX(0, 7) | MX_PLAIN },      /* DOWN     */
+    [0x52] = { MX(0, 7) | MX_SHIFT, MX(0, 7) | MX_SHIFT },      /* UP       */
+  }
+};
+
+/*
+ * ZX Spectrum: rows are address lines A8..A15, columns D0..D4.
+ *
+ *        D0     D1     D2     D3     D4
+ *  A8    CAPS   Z      X      C      V
+ *  A9    A      S      D      F      G
+ *  A10   Q      W      E      R      T
+ *  A11   1      2      3      4      5
+ *  A12   0      9      8      7      6
+ *  A13   P      O      I      U      Y
+ *  A14   ENTER  L      K      J      H
+ *  A15   SPACE  SYM    M      N      B
+ *
+ * most punctuation lives on SYMBOL SHIFT, the edit keys on CAPS SHIFT.
+ */
+const MatrixMachine matrix_zx = {
+  "zx spectrum", MATRIX_ONE_HOT, 8, MX_POS(MX(0, 0)), MX_POS(MX(7, 1)),
+  { MX(7, 1), MX(0, 0), 0, 0, MX(7, 1), MX(0, 0), 0, 0 },
+  {
+    [0x04] = K(1, 0), [0x05] = K(7, 4), [0x06] = K(0, 3), [0x07] = K(1, 2),
+    [0x08] = K(2, 2), [0x09] = K(1, 3), [0x0A] = K(1, 4), [0x0B] = K(6, 4),
+    [0x0C] = K(5, 2), [0x0D] = K(6, 3), [0x0E] = K(6, 2), [0x0F] = K(6, 1),
+    [0x10] = K(7, 2), [0x11] = K(7, 3), [0x12] = K(5, 1), [0x13] = K(5, 0),
+    [0x14] = K(2, 0), [0x15] = K(2, 3), [0x16] = K(1, 1), [0x17] = K(2, 4),
+    [0x18] = K(5, 3), [0x19] = K(0, 4), [0x1A] = K(2, 1), [0x1B] = K(0, 2),
+    [0x1C] = K(5, 4), [0x1D] = K(0, 1),
+    [0x1E] = { MX(3, 0) | MX_PLAIN, MX(3, 0) | MX_SYM },        /* 1 !      */
+    [0x1F] = { MX(3, 1) | MX_PLAIN, MX(3, 1) | MX_SYM },        /* 2 @      */
+    [0x20] = { MX(3, 2) | MX_PLAIN, MX(3, 2) | MX_SYM },        /* 3 #      */
+    [0x21] = { MX(3, 3) | MX_PLAIN, MX(3, 3) | MX_SYM },        /* 4 $      */
+    [0x22] = { MX(3, 4) | MX_PLAIN, MX(3, 4) | MX_SYM },        /* 5 %      */
+    [0x23] = { MX(4, 4) | MX_PLAIN, MX(6, 4) | MX_SYM },        /* 6 ^      */
+    [0x24] = { MX(4, 3) | MX_PLAIN, MX(4, 4) | MX_SYM },        /* 7 &      */
+    [0x25] = { MX(4, 2) | MX_PLAIN, MX(7, 4) | MX_SYM },        /* 8 *      */
+    [0x26] = { MX(4, 1) | MX_PLAIN, MX(4, 2) | MX_SYM },        /* 9 (      */
+    [0x27] = { MX(4, 0) | MX_PLAIN, MX(4, 1) | MX_SYM },        /* 0 )      */
+    [0x28] = K(6, 0),                                           /* ENTER    */
+    [0x29] = { MX(7, 0) | MX_SHIFT, MX(7, 0) | MX_SHIFT },      /* BREAK    */
+    [0x2A] = { MX(4, 0) | MX_SHIFT, MX(4, 0) | MX_SHIFT },      /* DELETE   */
+    [0x2C] = K(7, 0),                                           /* SPACE    */
+    [0x2D] = { MX(6, 3) | MX_SYM, MX(4, 0) | MX_SYM },          /* - _      */
+    [0x2E] = { MX(6, 1) | MX_SYM, MX(6, 2) | MX_SYM },          /* = +      */
+    [0x33] = { MX(5, 1) | MX_SYM, MX(0, 1) | MX_SYM },          /* ; :      */
+    [0x34] = { MX(4, 3) | MX_SYM, MX(5, 0) | MX_SYM },          /* ' "      */
+    [0x36] = { MX(7, 3) | MX_SYM, MX(2, 3) | MX_SYM },          /* , <      */
+    [0x37] = { MX(7, 2) | MX_SYM, MX(2, 4) | MX_SYM },          /* . >      */
+    [0x38] = { MX(0, 4) | MX_SYM, MX(0, 3) | MX_SYM },          /* / ?      */
+    [0x39] = { MX(3, 1) | MX_SHIFT, MX(3, 1) | MX_SHIFT },      /* CAPS LOCK*/
+    [0x4C] = { MX(4, 0) | MX_SHIFT, MX(4, 0) | MX_SHIFT },      /* DELETE   */
+    [0x4F] = { MX(4, 2) | MX_SHIFT, MX(4, 2) | MX_SHIFT },      /* RIGHT    */
+    [0x50] = { MX(3, 4) | MX_SHIFT, MX(3, 4) | MX_SHIFT },      /* LEFT     */
+    [0x51] = { MX(4, 4) | MX_SHIFT, MX(4, 4) | MX_SHIFT },      /* DOWN     */
+    [0x52] = { MX(4, 3) | MX_SHIFT, MX(4, 3) | MX_SHIFT },      /* UP       */
+  }
+};
+
+/*
+ * MSX (international layout): the row number 0..8 comes from PPI
+ * port C bits 0..3, columns are port B. the PC layout already matches.
+ *
+ *        B0     B1     B2     B3     B4     B5     B6     B7
+ *  0     0      1      2      3      4      5      6      7
+ *  1     8      9      -      =      \      [      ]      ;
+ *  2     '      `      ,      .      /      DEAD   A      B
+ *  3     C      D      E      F      G      H      I      J
+ *  4     K      L      M      N      O      P      Q      R
+ *  5     S      T      U      V      W      X      Y      Z
+ *  6     SHIFT  CTRL   GRAPH  CAPS   CODE   F1     F2     F3
+ *  7     F4     F5     ESC    TAB    STOP   BS     SELECT RETURN
+ *  8     SPACE  HOME   INS    DEL    LEFT   UP     DOWN   RIGHT
+ */
+const MatrixMachine matrix_msx = {
+  "msx", MATRIX_BINARY, 4, MX_POS(MX(6, 0)), 0xFF,
+  { MX(6, 1), MX(6, 0), MX(6, 2), 0, MX(6, 1), MX(6, 0), MX(6, 4), 0 },
+  {
+    [0x04] = K(2, 6), [0x05] = K(2, 7), [0x06] = K(3, 0), [0x07] = K(3, 1),
+    [0x08] = K(3, 2), [0x09] = K(3, 3), [0x0A] = K(3, 4), [0x0B] = K(3, 5),
+    [0x0C] = K(3, 6), [0x0D] = K(3, 7), [0x0E] = K(4, 0), [0x0F] = K(4, 1),
+    [0x10] = K(4, 2), [0x11] = K(4, 3), [0x12] = K(4, 4), [0x13] = K(4, 5),
+    [0x14] = K(4, 6), [0x15] = K(4, 7), [0x16] = K(5, 0), [0x17] = K(5, 1),
+    [0x18] = K(5, 2), [0x19] = K(5, 3), [0x1A] = K(5, 4), [0x1B] = K(5, 5),
+    [0x1C] = K(5, 6), [0x1D] = K(5, 7),
+    [0x1E] = K(0, 1), [0x1F] = K(0, 2), [0x20] = K(0, 3), [0x21] = K(0, 4),
+    [0x22] = K(0, 5), [0x23] = K(0, 6), [0x24] = K(0, 7), [0x25] = K(1, 0),
+    [0x26] = K(1, 1), [0x27] = K(0, 0),
+    [0x28] = K(7, 7), [0x29] = K(7, 2), [0x2A] = K(7, 5), [0x2B] = K(7, 3),
+    [0x2C] = K(8, 0), [0x2D] = K(1, 2), [0x2E] = K(1, 3), [0x2F] = K(1, 5),
+    [0x30] = K(1, 6), [0x31] = K(1, 4), [0x33] = K(1, 7), [0x34] = K(2, 0),
+    [0x35] = K(2, 1), [0x36] = K(2, 2), [0x37] = K(2, 3), [0x38] = K(2, 4),
+    [0x39] = K(6, 3),
+    [0x3A] = K(6, 5), [0x3B] = K(6, 6), [0x3C] = K(6, 7), [0x3D] = K(7, 0),
+    [0x3E] = K(7, 1), [0x3F] = K(7, 6), [0x48] = K(7, 4),      /* F6 = SELECT, PAUSE = STOP */
+    [0x49] = K(8, 2), [0x4A] = K(8, 1), [0x4C] = K(8, 3),
+    [0x4F] = K(8, 7), [0x50] = K(8, 4), [0x51] = K(8, 6), [0x52] = K(8, 5),
+  }
+};
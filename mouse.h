@@ -0,0 +1,10 @@
+#define MOUSE_SERIAL  0     // position tracking on the console uart
+#define MOUSE_PS2     1
+#define MOUSE_AMIGA   2     // quadrature
+#define MOUSE_ATARI   3     // quadrature, Atari ST pinout
+#define MOUSE_C1351   4     // Commodore 1351, PAL
+#define MOUSE_C1351N  5     // Commodore 1351, NTSC
+#define MOUSE_TABLET_MM     6   // Summagraphics MM serial tablet
+#define MOUSE_TABLET_WACOM  7   // Wacom IV serial tablet
+
+extern uint8_t mouse_out;
@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "mouse.h"
+#include "mouse_ringbuffer.h"
+#include "mouse_accel.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+#define Q16(x)  ((uint32_t) ((x) * 65536))
+
+extern bool debug;
+
+// the host OS of a PS/2 mouse has its own acceleration, the 8 bit
+// machines and the IKBD / ADB links get some, the C64 screen is small
+const MouseProfile mouse_profiles[] = {
+  [MOUSE_SERIAL]       = { "console",    Q16(1),   Q16(1),   false, false, 4, 24, Q16(2),   1 },
+  [MOUSE_PS2]          = { "ps/2",       Q16(1),   Q16(1),   false, false, 0, 0,  Q16(1),   1 },
+  [MOUSE_AMIGA]        = { "amiga",      Q16(1),   Q16(1),   false, false, 6, 32, Q16(2),   1 },
+  [MOUSE_ATARI]        = { "atari st",   Q16(1),   Q16(1),   false, false, 6, 32, Q16(2),   1 },
+  [MOUSE_C1351]        = { "c1351",      Q16(0.5), Q16(0.5), false, false, 4, 24, Q16(2),   2 },
+  [MOUSE_C1351N]       = { "c1351",      Q16(0.5), Q16(0.5), false, false, 4, 24, Q16(2),   2 },
+  [MOUSE_TABLET_MM]    = { "tablet",     Q16(1),   Q16(1),   false, false, 0, 0,  Q16(1),   1 },
+  [MOUSE_TABLET_WACOM] = { "tablet",     Q16(1),   Q16(1),   false, false, 0, 0,  Q16(1),   1 },
+  [MOUSE_PROFILE_LINK] = { "link",       Q16(1),   Q16(1),   false, false, 6, 32, Q16(1.5), 1 }
+};
+
+static int32_t  gain_x[ACCEL_SPEEDS];      // Q16, sensitivity and sign included
+static int32_t  gain_y[ACCEL_SPEEDS];
+static uint8_t  shift;                     // log2 of the smoothing window
+static int16_t  hist_x[4], hist_y[4];
+static int32_t  sum_x, sum_y;
+static uint8_t  hist_pos;
+static int32_t  rem_x, rem_y;              // Q16 fractions not sent yet
+static uint8_t  buttons;
+static uint64_t last_report;
+
+// everything that is per speed, not per report, is done here once
+void mouse_accel_init(const MouseProfile *p) {
+  int v;
+
+  for (v = 0; v < ACCEL_SPEEDS; v++) {
+    int64_t g = 65536;
+
+    if (v >= p->saturate)
+      g = p->max_gain;
+    else if (v > p->threshold)
+      g = 65536 + ((int64_t) p->max_gain - 65536) * (v - p->threshold) / (p->saturate - p->threshold);
+    gain_x[v] = (g * p->sens_x) >> 16;
+    gain_y[v] = (g * p->sens_y) >> 16;
+    if (p->invert_x)
+      gain_x[v] = -gain_x[v];
+    if (p->invert_y)
+      gain_y[v] = -gain_y[v];
+  }
+  shift = (p->smooth >= 4) ? 2 : (p->smooth >= 2) ? 1 : 0;
+  memset(hist_x, 0, sizeof(hist_x));
+  memset(hist_y, 0, sizeof(hist_y));
+  sum_x = sum_y = 0;
+  rem_x = rem_y = 0;
+  hist_pos = 0;
+  if (debug)
+    printf("mouse profile %s\n", p->name);
+}
+
+// Q16 amount plus the kept fraction, whole counts out
+HOTSPOT static int16_t take(int32_t *rem, int32_t sum, int32_t gain) {
+  int64_t v = *rem + (((int64_t) sum * gain) >> shift);
+  int32_t out = v / 65536;
+
+  if (v > (int64_t) 32767 * 65536)
+    out = 32767;
+  if (v < (int64_t) -32767 * 65536)
+    out = -32767;
+  *rem = v - (int64_t) out * 65536;
+  return out;
+}
+
+// average over the window, gain by the speed of the average: one
+// table read and one multiply per axis
+void mouse_accel(MouseEvent *event) {
+  uint8_t n = 1 << shift;
+  int32_t speed;
+
+  hist_pos = (hist_pos + 1) & (n - 1);
+  sum_x += event->delta_x - hist_x[hist_pos];
+  sum_y += event->delta_y - hist_y[hist_pos];
+  hist_x[hist_pos] = event->delta_x;
+  hist_y[hist_pos] = event->delta_y;
+  speed = (abs(sum_x) + abs(sum_y)) >> shift;
+  if (speed >= ACCEL_SPEEDS)
+    speed = ACCEL_SPEEDS - 1;
+  event->delta_x = take(&rem_x, sum_x, gain_x[speed]);
+  event->delta_y = take(&rem_y, sum_y, gain_y[speed]);
+  buttons     = event->buttons;
+  last_report = time_us_64();
+}
+
+// a mouse at rest sends nothing: push empty reports until what is
+// left in the smoothing window has come out
+void mouse_accel_task(MouseRingBuffer *mrb) {
+  MouseEvent event = { 0, 0, 0, 0, buttons };
+
+  if (!shift || (!sum_x && !sum_y) || (time_us_64() - last_report < ACCEL_IDLE_US))
+    return;
+  if (MouseAddEvent(mrb, &event))
+    last_report = time_us_64();
+}
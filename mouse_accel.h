@@ -0,0 +1,24 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+// needs mouse_ringbuffer.h first
+
+#define ACCEL_SPEEDS        64      // gain table entries, counts per report
+#define ACCEL_IDLE_US       8000    // no report that long: the smoothing window drains
+#define MOUSE_PROFILE_LINK  8       // after the MOUSE_* outputs: IKBD and ADB, on the keyboard link
+
+typedef struct {
+  const char *name;
+  uint32_t sens_x, sens_y;          // Q16, 65536 = 1:1
+  bool     invert_x, invert_y;
+  uint16_t threshold;               // speed where the acceleration starts
+  uint16_t saturate;                // speed where it reaches max_gain
+  uint32_t max_gain;                // Q16
+  uint8_t  smooth;                  // reports averaged, 1, 2 or 4
+} MouseProfile;
+
+extern const MouseProfile mouse_profiles[];
+
+void mouse_accel_init(const MouseProfile *);
+void mouse_accel(MouseEvent *);
+void mouse_accel_task(MouseRingBuffer *);
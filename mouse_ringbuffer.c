@@ -22,29 +22,19 @@ bool isMouseRingBufferFull(MouseRingBuffer *mrb) {
   return mrb->size == mrb->maxsize;
 }
 
-bool MouseAddEvent(MouseRingBuffer *mrb, int8_t dx, int8_t dy, int8_t dw, bool left, bool right, bool middle) {
+bool MouseAddEvent(MouseRingBuffer *mrb, const MouseEvent *event) {
   if (isMouseRingBufferFull(mrb)) 
-    false;
-  mrb->data[mrb->tail].delta_x       = dx;
-  mrb->data[mrb->tail].delta_y       = dy;
-  mrb->data[mrb->tail].delta_wheel   = dw;
-  mrb->data[mrb->tail].button_left   = left;
-  mrb->data[mrb->tail].button_right  = right;
-  mrb->data[mrb->tail].button_middle = middle;
+    return false;
+  mrb->data[mrb->tail] = *event;
   mrb->tail = (mrb->tail + 1) % mrb->maxsize;
   mrb->size++;
   return true;
 }
 
-bool MouseGetEvent(MouseRingBuffer *mrb, int8_t *dx, int8_t *dy, int8_t *dw, bool *left, bool *right, bool *middle) {
+bool MouseGetEvent(MouseRingBuffer *mrb, MouseEvent *event) {
   if (isMouseRingBufferEmpty(mrb)) 
     return false;
-  *dx     = mrb->data[mrb->head].delta_x;
-  *dy     = mrb->data[mrb->head].delta_y;
-  *dw     = mrb->data[mrb->head].delta_wheel;
-  *left   = mrb->data[mrb->head].button_left;
-  *right  = mrb->data[mrb->head].button_right;
-  *middle = mrb->data[mrb->head].button_middle;
+  *event = mrb->data[mrb->head];
   mrb->head = (mrb->head + 1) % mrb->maxsize;
   mrb->size--;
   return true;
@@ -55,13 +45,12 @@ void MouseRingBufferDump(MouseRingBuffer *mrb) {
     return;
   int index = mrb->head;
   for (int i = 0; i < mrb->size; i++) {
-    printf("%d %d %d %d %d %d\n",
+    printf("%d %d %d %d %02x\n",
 	   mrb->data[index].delta_x, 
 	   mrb->data[index].delta_y, 
 	   mrb->data[index].delta_wheel, 
-	   mrb->data[index].button_left, 
-	   mrb->data[index].button_right, 
-	   mrb->data[index].button_middle);
+	   mrb->data[index].delta_pan, 
+	   mrb->data[index].buttons);
     index = (index + 1) % mrb->maxsize;
   }
 }
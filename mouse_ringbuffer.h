@@ -5,13 +5,19 @@
 
 #define MOUSE_BUFFER_SIZE 32
 
+// buttons in the USB report bit order
+#define MOUSE_BTN_LEFT     0x01
+#define MOUSE_BTN_RIGHT    0x02
+#define MOUSE_BTN_MIDDLE   0x04
+#define MOUSE_BTN_BACK     0x08
+#define MOUSE_BTN_FORWARD  0x10
+
 typedef struct {
-  int8_t delta_x;
-  int8_t delta_y;
-  int8_t delta_wheel;
-  bool   button_left;
-  bool   button_right;
-  bool   button_middle;
+  int16_t delta_x;
+  int16_t delta_y;
+  int8_t  delta_wheel;
+  int8_t  delta_pan;
+  uint8_t buttons;                  // MOUSE_BTN_* bits
 } MouseEvent;
 
 typedef struct {
@@ -25,8 +31,8 @@ typedef struct {
 MouseRingBuffer *MouseRingBufferCreate(); 
 bool isMouseRingBufferEmpty(MouseRingBuffer *);
 bool isMouseRingBufferFull(MouseRingBuffer *);
-bool MouseAddEvent(MouseRingBuffer *, int8_t, int8_t, int8_t, bool, bool, bool);
-bool MouseGetEvent(MouseRingBuffer *, int8_t *, int8_t *, int8_t *, bool *, bool *, bool *);
+bool MouseAddEvent(MouseRingBuffer *, const MouseEvent *);
+bool MouseGetEvent(MouseRingBuffer *, MouseEvent *);
 void MouseRingBufferDump(MouseRingBuffer *);
 void MouseRingBufferRelease(MouseRingBuffer *);
 
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "ps2_device.h"
+#include "ps2_device.pio.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+// both programs can be loaded once per pio block and shared by
+// the keyboard and the mouse state machines
+static int ps2_offset[2] = { -1, -1 };
+static int xt_offset[2]  = { -1, -1 };
+
+// the state machine drives pindirs, so a 1 bit pulls the line low
+HOTSPOT static uint32_t ps2_frame(uint8_t data, bool xt) {
+  uint32_t frame;
+
+  if (xt) {
+    frame = 0x001 | ((uint32_t) data << 1);
+    return ~frame & 0x1FF;
+  }
+  frame  = (uint32_t) data << 1;
+  frame |= (__builtin_parity(data) ? 0 : 1) << 9;
+  frame |= 1 << 10;
+  return ~frame & 0x7FF;
+}
+
+void ps2_device_init(Ps2Device *dev, PIO pio, uint sm, uint pin, bool xt) {
+  uint index = pio_get_index(pio);
+
+  dev->pio  = pio;
+  dev->sm   = sm;
+  dev->pin  = pin;
+  dev->xt   = xt;
+  dev->busy = false;
+  dev->last = 0;
+  dev->hold_until = 0;
+  dev->head = 0;
+  dev->tail = 0;
+  dev->size = 0;
+  pio_sm_claim(pio, sm);
+  if (xt) {
+    if (xt_offset[index] < 0)
+      xt_offset[index] = pio_add_program(pio, &xt_device_program);
+    xt_device_program_init(pio, sm, xt_offset[index], pin);
+  } else {
+    if (ps2_offset[index] < 0)
+      ps2_offset[index] = pio_add_program(pio, &ps2_device_program);
+    ps2_device_program_init(pio, sm, ps2_offset[index], pin);
+  }
+}
+
+bool ps2_device_send(Ps2Device *dev, uint8_t data) {
+  if (dev->size == PS2_QUEUE_SIZE)
+    return false;
+  dev->data[dev->tail] = data;
+  dev->tail = (dev->tail + 1) % PS2_QUEUE_SIZE;
+  dev->size++;
+  return true;
+}
+
+// put the last byte back at the head of the queue (host sent 0xFE)
+void ps2_device_resend(Ps2Device *dev) {
+  if (dev->size == PS2_QUEUE_SIZE)
+    return;
+  dev->head = (dev->head + PS2_QUEUE_SIZE - 1) % PS2_QUEUE_SIZE;
+  dev->data[dev->head] = dev->last;
+  dev->size++;
+}
+
+// the host sent a command: whatever was still queued is obsolete
+void ps2_device_flush(Ps2Device *dev) {
+  dev->hold_until = 0;
+  dev->head = 0;
+  dev->tail = 0;
+  dev->size = 0;
+}
+
+// nothing queued and nothing on the wire
+bool ps2_device_idle(Ps2Device *dev) {
+  return !dev->busy && (dev->size == 0);
+}
+
+// feed the state machine and collect what the host sent us
+// returns a host byte, PS2_RX_ERROR on a bad frame or PS2_RX_NONE
+int ps2_device_task(Ps2Device *dev) {
+  int result = PS2_RX_NONE;
+
+  while ((result == PS2_RX_NONE) && !pio_sm_is_rx_fifo_empty(dev->pio, dev->sm)) {
+    uint32_t frame = pio_sm_get(dev->pio, dev->sm);
+
+    if (frame == PS2_FRAME_DONE) {
+      dev->busy = false;
+    } else if (frame == PS2_FRAME_ABORT) {
+      // the host may have aborted to send a command: the frame goes
+      // back to the head of the queue and waits until the host had the
+      // time to clock its byte in. if one comes, the frame is dropped
+      dev->busy = false;
+      if (dev->size < PS2_QUEUE_SIZE) {
+	ps2_device_resend(dev);
+	dev->hold_until = time_us_64() + PS2_ABORT_HOLD_US;
+      }
+    } else {
+      uint8_t data = (frame >> 1) & 0xFF;
+
+      if ((frame & 0x001) || !(frame & 0x400) ||
+	  (__builtin_parity(data) == ((frame >> 9) & 1)))
+	result = PS2_RX_ERROR;
+      else
+	result = data;
+    }
+  }
+  // a host byte first goes to the caller, who answers or flushes
+  if (result != PS2_RX_NONE) {
+    if (dev->hold_until) {
+      dev->head = (dev->head + 1) % PS2_QUEUE_SIZE;
+      dev->size--;
+    }
+    dev->hold_until = 0;
+    return result;
+  }
+  if (dev->hold_until) {
+    if (!gpio_get(dev->pin + 1))
+      dev->hold_until = time_us_64() + PS2_ABORT_HOLD_US;
+    else if (time_us_64() >= dev->hold_until)
+      dev->hold_until = 0;
+    if (dev->hold_until)
+      return result;
+  }
+  if (dev->xt) {
+    while ((dev->size > 0) && !pio_sm_is_tx_fifo_full(dev->pio, dev->sm)) {
+      dev->last = dev->data[dev->head];
+      dev->head = (dev->head + 1) % PS2_QUEUE_SIZE;
+      dev->size--;
+      pio_sm_put(dev->pio, dev->sm, ps2_frame(dev->last, true));
+    }
+  } else if (!dev->busy && (dev->size > 0)) {
+    // one frame in flight at a time so an aborted frame is resent in order
+    dev->last = dev->data[dev->head];
+    dev->head = (dev->head + 1) % PS2_QUEUE_SIZE;
+    dev->size--;
+    dev->busy = true;
+    pio_sm_put(dev->pio, dev->sm, ps2_frame(dev->last, false));
+  }
+  return result;
+}
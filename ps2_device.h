@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/pio.h"
+
+#define PS2_QUEUE_SIZE   16
+
+#define PS2_FRAME_DONE   0x80000000
+#define PS2_FRAME_ABORT  0xFFFFFFFF
+
+#define PS2_ABORT_HOLD_US 2000     // after an abort, CLK high this long before the frame goes again
+
+#define PS2_RX_NONE      -1
+#define PS2_RX_ERROR     -2
+
+typedef struct {
+  PIO      pio;
+  uint     sm;
+  uint     pin;             // DAT, CLK is pin + 1
+  bool     xt;              // XT: no host to device traffic, no parity
+  bool     busy;            // a frame is owned by the state machine
+  uint8_t  last;            // last byte handed over, for resend / abort
+  uint64_t hold_until;      // aborted frame waits for a host command, 0 = not holding
+  uint8_t  data[PS2_QUEUE_SIZE];
+  int      head;
+  int      tail;
+  int      size;
+} Ps2Device;
+
+void ps2_device_init(Ps2Device *, PIO, uint, uint, bool);
+bool ps2_device_send(Ps2Device *, uint8_t);
+void ps2_device_resend(Ps2Device *);
+void ps2_device_flush(Ps2Device *);
+bool ps2_device_idle(Ps2Device *);
+int  ps2_device_task(Ps2Device *);
@@ -0,0 +1,291 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "ps2_device.h"
+#include "ps2_kbd.h"
+#include "kbd.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+#define PS2_E0          0x100       // extended key, E0 prefix
+
+#define PS2_ACK         0xFA
+#define PS2_RESEND      0xFE
+#define PS2_BAT_OK      0xAA
+#define PS2_ECHO        0xEE
+
+#define XT_RESET_US     10000       // host holds CLK low this long to reset an XT keyboard
+
+extern bool debug;
+extern bool capslock_state;
+extern bool numlock_state;
+extern bool scrolllock_state;
+
+// USB HID usage 0x00..0x73 to scan set 2
+static const uint16_t to_set2[0x74] = {
+  0x000, 0x000, 0x000, 0x000, 0x01C, 0x032, 0x021, 0x023,   /* 0x00 */
+  0x024, 0x02B, 0x034, 0x033, 0x043, 0x03B, 0x042, 0x04B,   /* 0x08 */
+  0x03A, 0x031, 0x044, 0x04D, 0x015, 0x02D, 0x01B, 0x02C,   /* 0x10 */
+  0x03C, 0x02A, 0x01D, 0x022, 0x035, 0x01A, 0x016, 0x01E,   /* 0x18 */
+  0x026, 0x025, 0x02E, 0x036, 0x03D, 0x03E, 0x046, 0x045,   /* 0x20 */
+  0x05A, 0x076, 0x066, 0x00D, 0x029, 0x04E, 0x055, 0x054,   /* 0x28 */
+  0x05B, 0x05D, 0x05D, 0x04C, 0x052, 0x00E, 0x041, 0x049,   /* 0x30 */
+  0x04A, 0x058, 0x005, 0x006, 0x004, 0x00C, 0x003, 0x00B,   /* 0x38 */
+  0x083, 0x00A, 0x001, 0x009, 0x078, 0x007, 0x000, 0x07E,   /* 0x40 */
+  0x000, 0x170, 0x16C, 0x17D, 0x171, 0x169, 0x17A, 0x174,   /* 0x48 */
+  0x16B, 0x172, 0x175, 0x077, 0x14A, 0x07C, 0x07B, 0x079,   /* 0x50 */
+  0x15A, 0x069, 0x072, 0x07A, 0x06B, 0x073, 0x074, 0x06C,   /* 0x58 */
+  0x075, 0x07D, 0x070, 0x071, 0x061, 0x12F, 0x137, 0x00F,   /* 0x60 */
+  0x008, 0x010, 0x018, 0x020, 0x028, 0x030, 0x038, 0x040,   /* 0x68 */
+  0x048, 0x050, 0x057, 0x05F                                /* 0x70 */
+};
+
+// USB HID usage 0x00..0x73 to scan set 1 (XT)
+static const uint16_t to_set1[0x74] = {
+  0x000, 0x000, 0x000, 0x000, 0x01E, 0x030, 0x02E, 0x020,   /* 0x00 */
+  0x012, 0x021, 0x022, 0x023, 0x017, 0x024, 0x025, 0x026,   /* 0x08 */
+  0x032, 0x031, 0x018, 0x019, 0x010, 0x013, 0x01F, 0x014,   /* 0x10 */
+  0x016, 0x02F, 0x011, 0x02D, 0x015, 0x02C, 0x002, 0x003,   /* 0x18 */
+  0x004, 0x005, 0x006, 0x007, 0x008, 0x009, 0x00A, 0x00B,   /* 0x20 */
+  0x01C, 0x001, 0x00E, 0x00F, 0x039, 0x00C, 0x00D, 0x01A,   /* 0x28 */
+  0x01B, 0x02B, 0x02B, 0x027, 0x028, 0x029, 0x033, 0x034,   /* 0x30 */
+  0x035, 0x03A, 0x03B, 0x03C, 0x03D, 0x03E, 0x03F, 0x040,   /* 0x38 */
+  0x041, 0x042, 0x043, 0x044, 0x057, 0x058, 0x000, 0x046,   /* 0x40 */
+  0x000, 0x152, 0x147, 0x149, 0x153, 0x14F, 0x151, 0x14D,   /* 0x48 */
+  0x14B, 0x150, 0x148, 0x045, 0x135, 0x037, 0x04A, 0x04E,   /* 0x50 */
+  0x11C, 0x04F, 0x050, 0x051, 0x04B, 0x04C, 0x04D, 0x047,   /* 0x58 */
+  0x048, 0x049, 0x052, 0x053, 0x056, 0x15D, 0x15E, 0x059,   /* 0x60 */
+  0x064, 0x065, 0x066, 0x067, 0x068, 0x069, 0x06A, 0x06B,   /* 0x68 */
+  0x06C, 0x06D, 0x06E, 0x076                                /* 0x70 */
+};
+
+// modifiers, USB HID usage 0xE0..0xE7
+static const uint16_t mod_set2[8] = { 0x014, 0x012, 0x011, 0x11F, 0x114, 0x059, 0x111, 0x127 };
+static const uint16_t mod_set1[8] = { 0x01D, 0x02A, 0x038, 0x15B, 0x11D, 0x036, 0x138, 0x15C };
+
+// media and power keys, KBD_KEY_MEDIA.. in kbd.h order
+static const uint16_t media_set2[KBD_MEDIA_KEYS] = {
+  0x134, 0x13B, 0x14D, 0x115, 0x123, 0x132, 0x121, 0x12B,
+  0x148, 0x13A, 0x110, 0x138, 0x130, 0x140, 0x137, 0x13F, 0x15E
+};
+static const uint16_t media_set1[KBD_MEDIA_KEYS] = {
+  0x122, 0x124, 0x119, 0x110, 0x120, 0x130, 0x12E, 0x121,
+  0x16C, 0x132, 0x165, 0x16A, 0x169, 0x16B, 0x15E, 0x15F, 0x163
+};
+
+static Ps2Device kbd;
+static bool      enabled;
+static uint8_t   scan_set;
+static uint8_t   expect;            // command waiting for its argument byte
+static uint8_t   typematic_key;
+static uint32_t  typematic_delay;   // us
+static uint32_t  typematic_period;  // us
+static uint64_t  typematic_next;
+static uint64_t  clk_low_since;
+
+static void send(uint8_t data) {
+  if (!ps2_device_send(&kbd, data) && debug)
+    printf("ps2 keyboard queue full\n");
+}
+
+// rate bits 0..4 and delay bits 5..6 of the 0xF3 argument
+static void typematic(uint8_t arg) {
+  typematic_delay  = (((arg >> 5) & 0x03) + 1) * 250000;
+  typematic_period = (8 + (arg & 0x07)) * (1 << ((arg >> 3) & 0x03)) * 4167;
+}
+
+static void defaults(void) {
+  scan_set      = kbd.xt ? PS2_SCAN_SET_1 : PS2_SCAN_SET_2;
+  typematic_key = 0;
+  expect        = 0;
+  typematic(0x2B);                  // 10.9 cps, 500 ms
+}
+
+static void scan_code(uint16_t code, bool make) {
+  if (code & PS2_E0)
+    send(0xE0);
+  if (scan_set == PS2_SCAN_SET_1)
+    send(make ? code & 0xFF : (code & 0xFF) | 0x80);
+  else {
+    if (!make)
+      send(0xF0);
+    send(code & 0xFF);
+  }
+}
+
+static void print_screen(bool make) {
+  if (scan_set == PS2_SCAN_SET_1) {
+    if (make) {
+      send(0xE0); send(0x2A); send(0xE0); send(0x37);
+    } else {
+      send(0xE0); send(0xB7); send(0xE0); send(0xAA);
+    }
+  } else {
+    if (make) {
+      send(0xE0); send(0x12); send(0xE0); send(0x7C);
+    } else {
+      send(0xE0); send(0xF0); send(0x7C); send(0xE0); send(0xF0); send(0x12);
+    }
+  }
+}
+
+// pause has no break code, make and break go out together
+static void pause_key(void) {
+  if (scan_set == PS2_SCAN_SET_1) {
+    send(0xE1); send(0x1D); send(0x45); send(0xE1); send(0x9D); send(0xC5);
+  } else {
+    send(0xE1); send(0x14); send(0x77); send(0xE1); send(0xF0); send(0x14); send(0xF0); send(0x77);
+  }
+}
+
+HOTSPOT static uint16_t lookup(uint8_t keycode) {
+  if (keycode >= KBD_KEY_MEDIA + KBD_MEDIA_KEYS)
+    return 0;
+  if (keycode >= KBD_KEY_MEDIA)
+    return (scan_set == PS2_SCAN_SET_1) ? media_set1[keycode - KBD_KEY_MEDIA] : media_set2[keycode - KBD_KEY_MEDIA];
+  if (keycode >= 0xE0)
+    return (scan_set == PS2_SCAN_SET_1) ? mod_set1[keycode & 0x07] : mod_set2[keycode & 0x07];
+  if (keycode < sizeof(to_set2) / sizeof(to_set2[0]))
+    return (scan_set == PS2_SCAN_SET_1) ? to_set1[keycode] : to_set2[keycode];
+  return 0;
+}
+
+void ps2_kbd_key_event(uint8_t keycode, bool pressed) {
+  uint16_t code;
+
+  if (!enabled)
+    return;
+  switch (keycode) {
+  case 0x46:
+    print_screen(pressed);
+    break;
+  case 0x48:
+    if (pressed)
+      pause_key();
+    break;
+  default:
+    if ((code = lookup(keycode)) == 0)
+      return;
+    scan_code(code, pressed);
+    // a real keyboard only repeats the last key pressed, never a modifier
+    if (pressed && (keycode < 0xE0)) {
+      typematic_key  = keycode;
+      typematic_next = time_us_64() + typematic_delay;
+    }
+    break;
+  }
+  if (!pressed && (keycode == typematic_key))
+    typematic_key = 0;
+}
+
+static void command(uint8_t cmd) {
+  if (expect && (cmd < 0x80)) {
+    send(PS2_ACK);
+    switch (expect) {
+    case 0xED:
+      // usb_hid.c keeps numlock_state inverted
+      scrolllock_state = (cmd & 0x01) ? true : false;
+      numlock_state    = (cmd & 0x02) ? false : true;
+      capslock_state   = (cmd & 0x04) ? true : false;
+      break;
+    case 0xF0:
+      if (cmd == 0)
+	send(scan_set);
+      else if ((cmd == PS2_SCAN_SET_1) || (cmd == PS2_SCAN_SET_2))
+	scan_set = cmd;
+      break;
+    case 0xF3:
+      typematic(cmd);
+      break;
+    }
+    expect = 0;
+    return;
+  }
+  expect = 0;
+  ps2_device_flush(&kbd);
+  switch (cmd) {
+  case 0xED:
+  case 0xF0:
+  case 0xF3:
+    send(PS2_ACK);
+    expect = cmd;
+    break;
+  case 0xEE:
+    send(PS2_ECHO);
+    break;
+  case 0xF2:
+    send(PS2_ACK);
+    send(0xAB);
+    send(0x83);
+    break;
+  case 0xF4:
+    send(PS2_ACK);
+    enabled = true;
+    break;
+  case 0xF5:
+    send(PS2_ACK);
+    defaults();
+    enabled = false;
+    break;
+  case 0xF6:
+    send(PS2_ACK);
+    defaults();
+    break;
+  case 0xF7: case 0xF8: case 0xF9: case 0xFA:
+  case 0xFB: case 0xFC: case 0xFD:
+    send(PS2_ACK);                  // scan set 3 only, nothing to do
+    break;
+  case 0xFE:
+    ps2_device_resend(&kbd);
+    break;
+  case 0xFF:
+    send(PS2_ACK);
+    defaults();
+    enabled = true;
+    send(PS2_BAT_OK);
+    break;
+  default:
+    send(PS2_RESEND);
+    break;
+  }
+}
+
+void ps2_kbd_init(bool xt) {
+  ps2_device_init(&kbd, PS2_KBD_PIO, PS2_KBD_SM, PS2_KBD_DAT_PIN, xt);
+  defaults();
+  enabled       = true;
+  clk_low_since = 0;
+  send(PS2_BAT_OK);
+}
+
+void ps2_kbd_task(void) {
+  uint64_t now = time_us_64();
+  int rx;
+
+  if (kbd.xt) {
+    // XT hosts reset the keyboard by holding CLK low for ~20 ms,
+    // the self test result goes out once CLK is released
+    if (!gpio_get(PS2_KBD_DAT_PIN + 1)) {
+      if (clk_low_since == 0)
+	clk_low_since = now;
+    } else {
+      if (clk_low_since && ((now - clk_low_since) > XT_RESET_US)) {
+	ps2_device_flush(&kbd);
+	defaults();
+	send(PS2_BAT_OK);
+      }
+      clk_low_since = 0;
+    }
+  }
+  if ((rx = ps2_device_task(&kbd)) == PS2_RX_ERROR)
+    send(PS2_RESEND);
+  else if (rx >= 0) {
+    if (debug)
+      printf("ps2 host command %0.2x\n", rx);
+    command(rx);
+  }
+  if (typematic_key && (now >= typematic_next)) {
+    scan_code(lookup(typematic_key), true);
+    typematic_next += typematic_period;
+  }
+}
@@ -0,0 +1,14 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/pio.h"
+
+#define PS2_KBD_PIO      pio0
+#define PS2_KBD_SM       0
+#define PS2_KBD_DAT_PIN  2          // CLK is GP3
+
+#define PS2_SCAN_SET_1   1
+#define PS2_SCAN_SET_2   2
+
+void ps2_kbd_init(bool);
+void ps2_kbd_key_event(uint8_t, bool);
+void ps2_kbd_task(void);
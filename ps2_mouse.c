@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "ps2_device.h"
+#include "ps2_mouse.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+#define PS2_ACK         0xFA
+#define PS2_RESEND      0xFE
+#define PS2_BAT_OK      0xAA
+
+extern bool debug;
+
+static Ps2Device mouse;
+static bool      reporting;         // data reporting enabled (F4)
+static bool      remote;            // remote mode, packets on 0xEB only
+static bool      wrap;              // echo mode
+static bool      scaling;           // 2:1 scaling
+static uint8_t   resolution;        // 0..3 = 1, 2, 4, 8 counts/mm
+static uint8_t   sample_rate;
+static uint8_t   id;
+static uint8_t   knock[3];          // last three sample rates, for the id magic
+static uint8_t   expect;            // command waiting for its argument byte
+static uint8_t   buttons;
+static uint8_t   last_buttons;
+static int32_t   acc_x, acc_y, acc_z;
+static uint32_t  period;            // us between two stream packets
+static uint64_t  next_report;
+
+static void send(uint8_t data) {
+  if (!ps2_device_send(&mouse, data) && debug)
+    printf("ps2 mouse queue full\n");
+}
+
+// movement the host has not asked for yet is not owed to it
+static void clear_motion(void) {
+  acc_x = 0;
+  acc_y = 0;
+  acc_z = 0;
+}
+
+static void defaults(void) {
+  clear_motion();
+  reporting   = false;
+  remote      = false;
+  scaling     = false;
+  resolution  = 2;
+  sample_rate = 100;
+  period      = 1000000 / sample_rate;
+  expect      = 0;
+}
+
+// USB counts go out 1:1 at the default 4 counts/mm, what does
+// not fit in a packet or is below one count stays accumulated
+HOTSPOT static int16_t take(int32_t *acc, int16_t min, int16_t max) {
+  int shift = resolution - 2;
+  int32_t v;
+
+  v = (shift >= 0) ? *acc << shift : *acc >> -shift;
+  if (v < min)
+    v = min;
+  if (v > max)
+    v = max;
+  *acc -= (shift >= 0) ? v >> shift : v << -shift;
+  return v;
+}
+
+HOTSPOT static int16_t scale(int16_t v) {
+  static const int16_t curve[6] = { 0, 1, 1, 3, 6, 9 };
+  int16_t a = (v < 0) ? -v : v;
+
+  a = (a < 6) ? curve[a] : a * 2;
+  if (a > 255)
+    a = 255;
+  return (v < 0) ? -a : a;
+}
+
+static bool report(bool force) {
+  int16_t x, y, z;
+  uint8_t b0;
+
+  x = take(&acc_x, -255, 255);
+  y = take(&acc_y, -255, 255);
+  z = (id == PS2_MOUSE_ID_STANDARD) ? 0 : take(&acc_z, -8, 7);
+  if (!force && !x && !y && !z && (buttons == last_buttons))
+    return false;
+  if (scaling && !remote) {
+    x = scale(x);
+    y = scale(y);
+  }
+  b0 = 0x08 | (buttons & 0x07);
+  if (x < 0)
+    b0 |= 0x10;
+  if (y < 0)
+    b0 |= 0x20;
+  send(b0);
+  send(x & 0xFF);
+  send(y & 0xFF);
+  if (id == PS2_MOUSE_ID_INTELLIMOUSE)
+    send(z & 0xFF);
+  else if (id == PS2_MOUSE_ID_EXPLORER)
+    send((z & 0x0F) | ((buttons & 0x18) << 1));
+  last_buttons = buttons;
+  return true;
+}
+
+// buttons in USB order, 4 and 5 only go out with the explorer id
+void ps2_mouse_move(int16_t dx, int16_t dy, int8_t dw, uint8_t b) {
+  buttons = b & 0x1F;
+  // nothing builds up while the host does not listen. remote mode
+  // keeps counters for 0xEB, saturating like the real ones
+  if (!reporting && !remote)
+    return;
+  // PS/2 counts Y and the wheel the other way round
+  acc_x += dx;
+  acc_y -= dy;
+  acc_z -= dw;
+  if (remote) {
+    acc_x = (acc_x < -255) ? -255 : (acc_x > 255) ? 255 : acc_x;
+    acc_y = (acc_y < -255) ? -255 : (acc_y > 255) ? 255 : acc_y;
+    acc_z = (acc_z < -8) ? -8 : (acc_z > 7) ? 7 : acc_z;
+  }
+}
+
+static void set_sample_rate(uint8_t rate) {
+  if (rate == 0)
+    rate = 10;
+  if (rate > 200)
+    rate = 200;
+  sample_rate = rate;
+  period      = 1000000 / rate;
+  knock[0] = knock[1];
+  knock[1] = knock[2];
+  knock[2] = rate;
+  if ((knock[0] == 200) && (knock[1] == 100) && (knock[2] == 80) && (id == PS2_MOUSE_ID_STANDARD))
+    id = PS2_MOUSE_ID_INTELLIMOUSE;
+  if ((knock[0] == 200) && (knock[1] == 200) && (knock[2] == 80) && (id == PS2_MOUSE_ID_INTELLIMOUSE))
+    id = PS2_MOUSE_ID_EXPLORER;
+}
+
+static void command(uint8_t cmd) {
+  if (wrap && (cmd != 0xEC) && (cmd != 0xFF)) {
+    send(cmd);
+    return;
+  }
+  if (expect) {
+    send(PS2_ACK);
+    if (expect == 0xF3)
+      set_sample_rate(cmd);
+    else if (expect == 0xE8)
+      resolution = cmd & 0x03;
+    expect = 0;
+    return;
+  }
+  ps2_device_flush(&mouse);
+  switch (cmd) {
+  case 0xE6:
+  case 0xE7:
+    send(PS2_ACK);
+    scaling = (cmd == 0xE7);
+    break;
+  case 0xE8:
+  case 0xF3:
+    send(PS2_ACK);
+    expect = cmd;
+    break;
+  case 0xE9:
+    send(PS2_ACK);
+    send((remote ? 0x40 : 0) | (reporting ? 0x20 : 0) | (scaling ? 0x10 : 0) |
+	 ((buttons & MOUSE_BUTTON_LEFT) ? 0x04 : 0) |
+	 ((buttons & MOUSE_BUTTON_MIDDLE) ? 0x02 : 0) |
+	 ((buttons & MOUSE_BUTTON_RIGHT) ? 0x01 : 0));
+    send(resolution);
+    send(sample_rate);
+    break;
+  case 0xEA:
+    send(PS2_ACK);
+    clear_motion();
+    remote = false;
+    break;
+  case 0xEB:
+    send(PS2_ACK);
+    report(true);
+    break;
+  case 0xEC:
+    send(PS2_ACK);
+    wrap = false;
+    break;
+  case 0xEE:
+    send(PS2_ACK);
+    wrap = true;
+    break;
+  case 0xF0:
+    send(PS2_ACK);
+    clear_motion();
+    remote = true;
+    break;
+  case 0xF2:
+    send(PS2_ACK);
+    send(id);
+    break;
+  case 0xF4:
+    send(PS2_ACK);
+    clear_motion();
+    reporting = true;
+    break;
+  case 0xF5:
+    send(PS2_ACK);
+    clear_motion();
+    reporting = false;
+    break;
+  case 0xF6:
+    send(PS2_ACK);
+    defaults();
+    break;
+  case 0xFE:
+    ps2_device_resend(&mouse);
+    break;
+  case 0xFF:
+    send(PS2_ACK);
+    defaults();
+    wrap = false;
+    id   = PS2_MOUSE_ID_STANDARD;
+    send(PS2_BAT_OK);
+    send(id);
+    break;
+  default:
+    send(PS2_RESEND);
+    break;
+  }
+}
+
+void ps2_mouse_init(void) {
+  ps2_device_init(&mouse, PS2_MOUSE_PIO, PS2_MOUSE_SM, PS2_MOUSE_DAT_PIN, false);
+  defaults();
+  wrap  = false;
+  id    = PS2_MOUSE_ID_STANDARD;
+  acc_x = acc_y = acc_z = 0;
+  buttons = last_buttons = 0;
+  next_report = time_us_64();
+  send(PS2_BAT_OK);
+  send(id);
+}
+
+// stream packets go out on the host sample clock: whatever the USB
+// mouse sent in between is merged, so a 1 kHz mouse never builds a
+// backlog on a 100 Hz link
+void ps2_mouse_task(void) {
+  uint64_t now = time_us_64();
+  int rx;
+
+  if ((rx = ps2_device_task(&mouse)) == PS2_RX_ERROR)
+    send(PS2_RESEND);
+  else if (rx >= 0) {
+    if (debug)
+      printf("ps2 host command %0.2x\n", rx);
+    command(rx);
+  }
+  if (!reporting || remote || wrap || expect) {
+    next_report = now + period;
+    return;
+  }
+  if (now < next_report)
+    return;
+  next_report += period;
+  if (next_report <= now)
+    next_report = now + period;
+  // a packet still on the wire means the slot is skipped, not queued
+  if (ps2_device_idle(&mouse))
+    report(false);
+}
@@ -0,0 +1,15 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/pio.h"
+
+#define PS2_MOUSE_PIO      pio0
+#define PS2_MOUSE_SM       1
+#define PS2_MOUSE_DAT_PIN  4        // CLK is GP5
+
+#define PS2_MOUSE_ID_STANDARD     0x00
+#define PS2_MOUSE_ID_INTELLIMOUSE 0x03
+#define PS2_MOUSE_ID_EXPLORER     0x04
+
+void ps2_mouse_init(void);
+void ps2_mouse_move(int16_t, int16_t, int8_t, uint8_t);
+void ps2_mouse_task(void);
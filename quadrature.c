@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "quadrature.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+#define QUAD_MASK   (0x0F << QUAD_PIN_BASE)
+
+// DB9 pin (1..4) carrying XA, XB, YA, YB
+static const uint8_t db9_pins[2][4] = {
+  { 2, 4, 1, 3 },   // Amiga: H, HQ, V, VQ
+  { 2, 1, 3, 4 },   // Atari ST
+};
+
+// gray code sequence, index = phase
+static const uint8_t gray[4] = { 0x0, 0x1, 0x3, 0x2 };
+
+static uint32_t         lut[16];    // (phase y << 2) | phase x to GPIO levels
+static volatile int32_t pending_x;
+static volatile int32_t pending_y;
+static uint8_t          phase_x;
+static uint8_t          phase_y;
+
+// runs from the timer irq: one step per axis, the next step is
+// scheduled so that the current backlog drains in QUAD_DRAIN_US
+static int64_t quad_step(alarm_id_t id, void *user_data) {
+  int32_t backlog, x, y;
+
+  x = pending_x;
+  y = pending_y;
+  if (x > 0) {
+    phase_x = (phase_x + 1) & 0x03;
+    pending_x = x - 1;
+  } else if (x < 0) {
+    phase_x = (phase_x - 1) & 0x03;
+    pending_x = x + 1;
+  }
+  if (y > 0) {
+    phase_y = (phase_y + 1) & 0x03;
+    pending_y = y - 1;
+  } else if (y < 0) {
+    phase_y = (phase_y - 1) & 0x03;
+    pending_y = y + 1;
+  }
+  gpio_put_masked(QUAD_MASK, lut[(phase_y << 2) | phase_x]);
+
+  x = (x < 0) ? -x : x;
+  y = (y < 0) ? -y : y;
+  backlog = (x > y) ? x : y;
+  if (backlog <= 1)
+    return QUAD_MAX_PERIOD_US;
+  backlog = QUAD_DRAIN_US / backlog;
+  if (backlog < QUAD_MIN_PERIOD_US)
+    return QUAD_MIN_PERIOD_US;
+  if (backlog > QUAD_MAX_PERIOD_US)
+    return QUAD_MAX_PERIOD_US;
+  return backlog;
+}
+
+// buttons are open collector, pulled low when pressed
+static void button(uint pin, bool pressed) {
+  gpio_set_dir(pin, pressed ? GPIO_OUT : GPIO_IN);
+}
+
+void quad_init(uint8_t machine) {
+  int i, px, py;
+
+  for (i = 0; i < 16; i++) {
+    px = gray[i & 0x03];
+    py = gray[i >> 2];
+    lut[i] = (((px & 1) ? 1 : 0) << (db9_pins[machine][0] - 1)) |
+             (((px & 2) ? 1 : 0) << (db9_pins[machine][1] - 1)) |
+             (((py & 1) ? 1 : 0) << (db9_pins[machine][2] - 1)) |
+             (((py & 2) ? 1 : 0) << (db9_pins[machine][3] - 1));
+    lut[i] <<= QUAD_PIN_BASE;
+  }
+  gpio_init_mask(QUAD_MASK);
+  gpio_put_masked(QUAD_MASK, lut[0]);
+  gpio_set_dir_out_masked(QUAD_MASK);
+  for (i = QUAD_PIN_LEFT; i <= QUAD_PIN_MIDDLE; i++) {
+    gpio_init(i);
+    gpio_put(i, false);
+    gpio_pull_up(i);
+    gpio_set_dir(i, GPIO_IN);
+  }
+  pending_x = 0;
+  pending_y = 0;
+  phase_x   = 0;
+  phase_y   = 0;
+  add_alarm_in_us(QUAD_MAX_PERIOD_US, quad_step, NULL, true);
+}
+
+// every USB count becomes one quadrature step
+void quad_move(int16_t dx, int16_t dy, bool left, bool right, bool middle) {
+  uint32_t irq;
+
+  irq = save_and_disable_interrupts();
+  pending_x += dx;
+  pending_y += dy;
+  restore_interrupts(irq);
+  button(QUAD_PIN_LEFT, left);
+  button(QUAD_PIN_RIGHT, right);
+  button(QUAD_PIN_MIDDLE, middle);
+}
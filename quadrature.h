@@ -0,0 +1,18 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+// GPIO n + QUAD_PIN_BASE carries DB9 pin 1..4, buttons follow
+#define QUAD_PIN_BASE       6
+#define QUAD_PIN_LEFT       (QUAD_PIN_BASE + 4)     // DB9 pin 6
+#define QUAD_PIN_RIGHT      (QUAD_PIN_BASE + 5)     // DB9 pin 9
+#define QUAD_PIN_MIDDLE     (QUAD_PIN_BASE + 6)     // DB9 pin 5
+
+#define QUAD_MIN_PERIOD_US  40      // fastest step rate, 25 kHz
+#define QUAD_MAX_PERIOD_US  1000    // slowest step rate, also the idle poll
+#define QUAD_DRAIN_US       8000    // time budget to flush a backlog of steps
+
+#define QUAD_AMIGA          0
+#define QUAD_ATARI_ST       1
+
+void quad_init(uint8_t);
+void quad_move(int16_t, int16_t, bool, bool, bool);
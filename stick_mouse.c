@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "pico/stdlib.h"
+#include "gamepad.h"
+#include "gamepad_state.h"
+#include "mouse_ringbuffer.h"
+#include "stick_mouse.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+#define CURVE_SHIFT  10             // 32 curve segments over the axis range
+
+extern bool debug;
+
+// pixels per tick in 1/256, (e^(3x) - 1) / (e^3 - 1) up to 16 pixels:
+// fine control near the center, fast across the screen at full tilt
+static const uint16_t curve[33] = {
+     0,   21,   44,   70,   98,  128,  162,  199,  240,  284,  333,
+   387,  446,  511,  583,  661,  747,  842,  946, 1060, 1185, 1322,
+  1473, 1639, 1822, 2022, 2242, 2483, 2748, 3039, 3359, 3710, 4096
+};
+
+static uint64_t next_tick;
+static int32_t  acc_x, acc_y;       // subpixel remainders, 1/256 pixel
+static uint16_t last_buttons;
+
+// stick position to signed speed, linear between the curve points
+HOTSPOT static int32_t speed(int16_t axis) {
+  int32_t v = abs(axis);
+  int32_t i, frac, s;
+
+  if (v <= STICK_DEADZONE)
+    return 0;
+  v = (v - STICK_DEADZONE) * GAMEPAD_AXIS_MAX / (GAMEPAD_AXIS_MAX - STICK_DEADZONE);
+  i    = v >> CURVE_SHIFT;
+  frac = v & ((1 << CURVE_SHIFT) - 1);
+  s    = curve[i];
+  if (i < 32)
+    s += ((curve[i + 1] - curve[i]) * frac) >> CURVE_SHIFT;
+  return (axis < 0) ? -s : s;
+}
+
+// whole pixels out of the accumulator, the remainder stays for later ticks
+HOTSPOT static int8_t take(int32_t *acc) {
+  int32_t d = *acc / 256;
+
+  if (d > 127)
+    d = 127;
+  if (d < -127)
+    d = -127;
+  *acc -= d * 256;
+  return d;
+}
+
+void stick_mouse_init(void) {
+  next_tick    = time_us_64() + STICK_TICK_US;
+  acc_x        = 0;
+  acc_y        = 0;
+  last_buttons = 0;
+  if (debug)
+    printf("stick mouse on player %d\n", STICK_PLAYER);
+}
+
+// one integration step every STICK_TICK_US, whatever the report rate
+void stick_mouse_task(MouseRingBuffer *mrb) {
+  uint64_t now = time_us_64();
+  GamepadState state;
+  MouseEvent event;
+  uint16_t buttons;
+  int32_t x, y;
+  int8_t dx, dy;
+
+  if (now < next_tick)
+    return;
+  // after a stall restart the pace instead of catching up in a burst
+  next_tick = (now - next_tick < STICK_TICK_US) ? next_tick + STICK_TICK_US : now + STICK_TICK_US;
+  if (!gamepad_read(STICK_PLAYER, &state, NULL))
+    return;
+  x = acc_x + speed(state.axis[STICK_AXIS_X]);
+  y = acc_y + speed(state.axis[STICK_AXIS_Y]);
+  // back to rest: drop the fraction so the pointer stops where it is
+  if (!state.axis[STICK_AXIS_X])
+    x = 0;
+  if (!state.axis[STICK_AXIS_Y])
+    y = 0;
+  dx = take(&x);
+  dy = take(&y);
+  buttons = state.buttons & (STICK_LEFT | STICK_RIGHT | STICK_MIDDLE);
+  if (!dx && !dy && (buttons == last_buttons)) {
+    acc_x = x;
+    acc_y = y;
+    return;
+  }
+  event.delta_x     = dx;
+  event.delta_y     = dy;
+  event.delta_wheel = 0;
+  event.delta_pan   = 0;
+  event.buttons     = ((buttons & STICK_LEFT)   ? MOUSE_BTN_LEFT   : 0) |
+                      ((buttons & STICK_RIGHT)  ? MOUSE_BTN_RIGHT  : 0) |
+                      ((buttons & STICK_MIDDLE) ? MOUSE_BTN_MIDDLE : 0);
+  // a full ring keeps the motion in the accumulators for the next tick
+  if (MouseAddEvent(mrb, &event))
+    last_buttons = buttons;
+  else {
+    x += dx * 256;
+    y += dy * 256;
+  }
+  acc_x = x;
+  acc_y = y;
+}
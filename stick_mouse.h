@@ -0,0 +1,14 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#define STICK_PLAYER       0
+#define STICK_AXIS_X       0
+#define STICK_AXIS_Y       1
+#define STICK_TICK_US      10000     // integrator step
+#define STICK_DEADZONE     2048      // on top of the model's, for drifting sticks
+#define STICK_LEFT         GAMEPAD_A
+#define STICK_RIGHT        GAMEPAD_B
+#define STICK_MIDDLE       GAMEPAD_X
+
+void stick_mouse_init(void);
+void stick_mouse_task(MouseRingBuffer *);
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/uart.h"
+#include "hardware/sync.h"
+#include "mouse_ringbuffer.h"
+#include "tablet.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+extern bool debug;
+
+// MM 1201: 12" at 500 lpi, Wacom UD-1212: 12" at 1270 lpi
+const TabletConfig tablet_configs[] = {
+  [TABLET_MM]       = { "summagraphics mm", 9600, true,  100, 6000,  6000,  1 },
+  [TABLET_WACOM_IV] = { "wacom iv",         9600, false, 100, 15240, 15240, 1 }
+};
+
+static const TabletConfig *config;
+static uint8_t  protocol;
+static repeating_timer_t timer;
+
+// latest state, a report always sends this, never a backlog
+static volatile uint32_t pos;       // y << 16 | x
+static volatile uint8_t  buttons;   // MOUSE_BTN_*
+static volatile bool     proximity;
+static int32_t  abs_x, abs_y;       // relative input, in mouse counts
+
+HOTSPOT static int clamp(int32_t v, int32_t max) {
+  return (v < 0) ? 0 : (v > max) ? max : v;
+}
+
+// summagraphics MM: 1 P 0 XS YS F2 F1 F0 (phasing 0x80, proximity 0x40,
+// X sign 0x10, Y sign 0x08, buttons 0x07) then X and Y as 7 bit pairs,
+// low first. positions are never negative, the proximity bit is set
+// while the cursor is away
+static int packet_mm(uint8_t *p, uint16_t x, uint16_t y, uint8_t b, bool prox) {
+  p[0] = 0x80 | (prox ? 0 : 0x40) | (b & 0x07);
+  p[1] = x & 0x7F;
+  p[2] = (x >> 7) & 0x7F;
+  p[3] = y & 0x7F;
+  p[4] = (y >> 7) & 0x7F;
+  return 5;
+}
+
+// wacom iv: 1 P 0 B 0 0 X15 X14, X13..7, X6..0, 0 B4..B1 0 0 Y15 Y14,
+// Y13..7, Y6..0, 0: a cursor (puck), bit 5 clear, no pressure
+static int packet_wacom(uint8_t *p, uint16_t x, uint16_t y, uint8_t b, bool prox) {
+  b &= 0x0F;
+  p[0] = 0x80 | (prox ? 0x40 : 0) | (b ? 0x08 : 0) | ((x >> 14) & 0x03);
+  p[1] = (x >> 7) & 0x7F;
+  p[2] = x & 0x7F;
+  p[3] = (b << 3) | ((y >> 14) & 0x03);
+  p[4] = (y >> 7) & 0x7F;
+  p[5] = y & 0x7F;
+  p[6] = 0;
+  return 7;
+}
+
+// timer irq at the report rate: a packet of the current position,
+// skipped if the previous one is still in the fifo
+static bool __not_in_flash_func(tablet_report)(repeating_timer_t *rt) {
+  uint8_t  p[8];
+  uint32_t xy = pos;
+  int len, i;
+
+  if (!(uart_get_hw(TABLET_UART)->fr & UART_UARTFR_TXFE_BITS))
+    return true;
+  if (protocol == TABLET_MM)
+    len = packet_mm(p, xy & 0xFFFF, xy >> 16, buttons, proximity);
+  else
+    len = packet_wacom(p, xy & 0xFFFF, xy >> 16, buttons, proximity);
+  for (i = 0; i < len; i++)
+    uart_get_hw(TABLET_UART)->dr = p[i];
+  return true;
+}
+
+void tablet_init(uint8_t proto) {
+  protocol  = proto;
+  config    = &tablet_configs[proto];
+  abs_x     = config->max_x / 2 * config->counts;
+  abs_y     = config->max_y / 2 * config->counts;
+  pos       = ((uint32_t) (config->max_y / 2) << 16) | (config->max_x / 2);
+  buttons   = 0;
+  proximity = true;
+  uart_init(TABLET_UART, config->baud);
+  uart_set_format(TABLET_UART, 8, 1, config->odd_parity ? UART_PARITY_ODD : UART_PARITY_NONE);
+  uart_set_hw_flow(TABLET_UART, false, false);
+  gpio_set_function(TABLET_TX_PIN, GPIO_FUNC_UART);
+  gpio_set_function(TABLET_RX_PIN, GPIO_FUNC_UART);
+  add_repeating_timer_us(-1000000 / config->rate_hz, tablet_report, NULL, &timer);
+  if (debug)
+    printf("%s tablet, %d x %d, %d reports/s\n", config->name, config->max_x, config->max_y, config->rate_hz);
+}
+
+// a mouse moves the cursor over the tablet, Y grows towards the user
+// on both, tablet origin in the lower left corner
+void tablet_move(int16_t dx, int16_t dy, uint8_t b) {
+  uint32_t irq;
+  int x, y;
+
+  abs_x = clamp(abs_x + dx, config->max_x * config->counts);
+  abs_y = clamp(abs_y + dy, config->max_y * config->counts);
+  x = abs_x / config->counts;
+  y = config->max_y - abs_y / config->counts;
+  irq = save_and_disable_interrupts();
+  pos       = ((uint32_t) y << 16) | x;
+  buttons   = b;
+  proximity = true;
+  restore_interrupts(irq);
+}
+
+// digitizers: position in their own range, origin top left
+void tablet_absolute(uint32_t x, uint32_t y, uint32_t max_x, uint32_t max_y, bool prox, uint8_t b) {
+  uint32_t irq;
+
+  if (!max_x || !max_y)
+    return;
+  x = (uint64_t) clamp(x, max_x) * config->max_x / max_x;
+  y = config->max_y - (uint64_t) clamp(y, max_y) * config->max_y / max_y;
+  irq = save_and_disable_interrupts();
+  pos       = (y << 16) | x;
+  buttons   = b;
+  proximity = prox;
+  restore_interrupts(irq);
+}
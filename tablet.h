@@ -0,0 +1,24 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TABLET_UART        uart1
+#define TABLET_TX_PIN      4        // through an RS-232 level shifter
+#define TABLET_RX_PIN      5
+
+#define TABLET_MM          0        // Summagraphics MM series, binary
+#define TABLET_WACOM_IV    1        // Wacom protocol IV, binary, 4 button cursor
+
+typedef struct {
+  const char *name;
+  uint32_t    baud;
+  bool        odd_parity;
+  uint16_t    rate_hz;              // reports per second
+  uint16_t    max_x, max_y;         // coordinate range
+  uint8_t     counts;               // mouse counts per tablet unit, for relative input
+} TabletConfig;
+
+extern const TabletConfig tablet_configs[];
+
+void tablet_init(uint8_t);
+void tablet_move(int16_t, int16_t, uint8_t);
+void tablet_absolute(uint32_t, uint32_t, uint32_t, uint32_t, bool, uint8_t);
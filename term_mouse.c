@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "pico/stdlib.h"
+#include "kbd_ringbuffer.h"
+#include "mouse_ringbuffer.h"
+#include "term_mouse.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+#define TMOUSE_MOTION   32          // added to the button code of a motion report
+#define TMOUSE_RELEASE  3
+#define TMOUSE_WHEEL    64          // 64 up, 65 down
+
+extern bool debug;
+
+typedef struct {
+  uint8_t code;                     // 0 left, 1 middle, 2 right
+  bool    release;
+  uint8_t held;                     // MOUSE_BTN_* after the event
+} TmouseClick;
+
+static int32_t     pos_x, pos_y;    // in mouse counts
+static uint8_t     col, row;        // cell of the pointer, from 1
+static uint8_t     buttons;
+static bool        moved;           // the cell changed since the last motion report
+static int16_t     wheel;           // notches not reported yet, up > 0
+static uint64_t    next_motion;
+static TmouseClick queue[TMOUSE_QUEUE];
+static uint8_t     head, count;
+
+static const uint8_t button_bit[3] = { MOUSE_BTN_LEFT, MOUSE_BTN_MIDDLE, MOUSE_BTN_RIGHT };
+
+#define SLOT(i)  queue[(head + (i)) % TMOUSE_QUEUE]
+
+// button transitions only, so a release never waits behind wheel
+// notches. when the host is not reading, the latest press / release
+// pair of one button is given up (there always is one in a full queue
+// of 3 buttons): the click is lost, what is held stays right
+static void push(uint8_t code, bool release) {
+  int i, j;
+
+  if (count == TMOUSE_QUEUE) {
+    for (j = count - 1; j > 0; j--) {
+      for (i = j - 1; (i >= 0) && (SLOT(i).code != SLOT(j).code); i--)
+	;
+      if (i >= 0)
+	break;
+    }
+    for (; i < count - 2; i++)
+      SLOT(i) = SLOT((i + 1 < j) ? i + 1 : i + 2);
+    count -= 2;
+  }
+  SLOT(count).code    = code;
+  SLOT(count).release = release;
+  SLOT(count).held    = buttons;
+  count++;
+}
+
+// button code of the first held button, for motion reports
+HOTSPOT static uint8_t held_code(uint8_t held) {
+  int i;
+
+  for (i = 0; i < 3; i++)
+    if (held & button_bit[i])
+      return i;
+  return TMOUSE_RELEASE;
+}
+
+// one complete report in buf, 0 when the mode does not report this event
+static int encode(char *buf, uint8_t code, bool release, bool motion, uint8_t held) {
+  uint8_t cb = code;
+  int pe, pb;
+
+  switch (tmouse_mode) {
+  case TMOUSE_LOCATOR:
+    if (motion || (code >= TMOUSE_WHEEL))
+      return 0;
+    pe = 2 + code * 2 + (release ? 1 : 0);
+    pb = ((held & MOUSE_BTN_RIGHT) ? 1 : 0) | ((held & MOUSE_BTN_MIDDLE) ? 2 : 0) | ((held & MOUSE_BTN_LEFT) ? 4 : 0);
+    return sprintf(buf, "\033[%d;%d;%d;%d;1&w", pe, pb, row, col);
+  case TMOUSE_X10:
+    if (motion || release || (code >= TMOUSE_WHEEL))
+      return 0;
+    break;
+  }
+  if (motion)
+    cb += TMOUSE_MOTION;
+  if (tmouse_sgr)
+    return sprintf(buf, "\033[<%d;%d;%d%c", cb, col, row, release ? 'm' : 'M');
+  // legacy encoding: the release does not say which button
+  if (release)
+    cb = TMOUSE_RELEASE;
+  buf[0] = '\033';
+  buf[1] = '[';
+  buf[2] = 'M';
+  buf[3] = 32 + cb;
+  buf[4] = 32 + ((col > 223) ? 223 : col);
+  buf[5] = 32 + ((row > 223) ? 223 : row);
+  return 6;
+}
+
+// all of a report or nothing, never half of an escape sequence
+static bool send(KbdRingBuffer *krb, const char *buf, int len) {
+  int i;
+
+  if (krb->maxsize - krb->size < len)
+    return false;
+  for (i = 0; i < len; i++)
+    KbdAddKey(krb, (uint8_t) buf[i]);
+  return true;
+}
+
+void term_mouse_init(void) {
+  pos_x   = TMOUSE_COLS * TMOUSE_CELL_X / 2;
+  pos_y   = TMOUSE_ROWS * TMOUSE_CELL_Y / 2;
+  col     = TMOUSE_COLS / 2 + 1;
+  row     = TMOUSE_ROWS / 2 + 1;
+  buttons = 0;
+  moved   = false;
+  wheel   = 0;
+  head    = 0;
+  count   = 0;
+  if (debug)
+    printf("terminal mouse mode %d%s, %dx%d\n", tmouse_mode, tmouse_sgr ? " sgr" : "", TMOUSE_COLS, TMOUSE_ROWS);
+}
+
+// track the pointer and queue the clicks, nothing is encoded yet
+void term_mouse_move(int16_t dx, int16_t dy, int8_t dw, uint8_t b) {
+  uint8_t c, r, changed = b ^ buttons;
+  int i;
+
+  pos_x += dx;
+  pos_y += dy;
+  pos_x = (pos_x < 0) ? 0 : (pos_x >= TMOUSE_COLS * TMOUSE_CELL_X) ? TMOUSE_COLS * TMOUSE_CELL_X - 1 : pos_x;
+  pos_y = (pos_y < 0) ? 0 : (pos_y >= TMOUSE_ROWS * TMOUSE_CELL_Y) ? TMOUSE_ROWS * TMOUSE_CELL_Y - 1 : pos_y;
+  c = pos_x / TMOUSE_CELL_X + 1;
+  r = pos_y / TMOUSE_CELL_Y + 1;
+  if ((c != col) || (r != row))
+    moved = true;
+  col = c;
+  row = r;
+  for (i = 0; i < 3; i++)
+    if (changed & button_bit[i]) {
+      buttons ^= button_bit[i];
+      push(i, !(b & button_bit[i]));
+    }
+  wheel += dw;
+}
+
+// absolute pointers place the cursor, 0..65535 across the screen
+void term_mouse_absolute(uint16_t x, uint16_t y, int8_t dw, uint8_t b) {
+  int32_t to_x = ((uint32_t) x * (TMOUSE_COLS * TMOUSE_CELL_X)) >> 16;
+  int32_t to_y = ((uint32_t) y * (TMOUSE_ROWS * TMOUSE_CELL_Y)) >> 16;
+
+  term_mouse_move(to_x - pos_x, to_y - pos_y, dw, b);
+}
+
+// clicks go out in order as soon as they fit, then the wheel one
+// notch at a time. motion is coalesced into the latest cell and only
+// sent when no keystroke is waiting
+void term_mouse_task(KbdRingBuffer *krb) {
+  char buf[24];
+  uint64_t now;
+  int len;
+
+  while (count) {
+    TmouseClick *q = &queue[head];
+
+    len = encode(buf, q->code, q->release, false, q->held);
+    if (len && !send(krb, buf, len))
+      return;
+    head = (head + 1) % TMOUSE_QUEUE;
+    count--;
+  }
+  while (wheel) {
+    len = encode(buf, (wheel > 0) ? TMOUSE_WHEEL : TMOUSE_WHEEL + 1, false, false, buttons);
+    if (len && !send(krb, buf, len))
+      return;
+    wheel += (wheel > 0) ? -1 : 1;
+  }
+  if (!moved)
+    return;
+  if ((tmouse_mode != TMOUSE_ANY) && ((tmouse_mode != TMOUSE_DRAG) || !buttons)) {
+    moved = false;
+    return;
+  }
+  now = time_us_64();
+  if ((now < next_motion) || !isKbdRingBufferEmpty(krb))
+    return;
+  len = encode(buf, held_code(buttons), false, true, buttons);
+  if (send(krb, buf, len)) {
+    moved = false;
+    next_motion = now + TMOUSE_MOTION_US;
+  }
+}
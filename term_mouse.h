@@ -0,0 +1,26 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+// needs kbd_ringbuffer.h first
+
+#define TMOUSE_OFF        0
+#define TMOUSE_X10        1         // ?9: button presses only
+#define TMOUSE_NORMAL     2         // ?1000: presses, releases and the wheel
+#define TMOUSE_DRAG       3         // ?1002: and motion while a button is held
+#define TMOUSE_ANY        4         // ?1003: and all motion
+#define TMOUSE_LOCATOR    5         // DEC locator, DECLRP on button transitions
+
+#define TMOUSE_COLS       80
+#define TMOUSE_ROWS       24
+#define TMOUSE_CELL_X     8         // mouse counts per column
+#define TMOUSE_CELL_Y     16        // per row
+#define TMOUSE_MOTION_US  50000     // at most one motion report in that time
+#define TMOUSE_QUEUE      8
+
+extern uint8_t tmouse_mode;
+extern bool    tmouse_sgr;          // ?1006 encoding for the xterm modes
+
+void term_mouse_init(void);
+void term_mouse_move(int16_t, int16_t, int8_t, uint8_t);
+void term_mouse_absolute(uint16_t, uint16_t, int8_t, uint8_t);
+void term_mouse_task(KbdRingBuffer *);
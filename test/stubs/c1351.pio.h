@@ -0,0 +1,3 @@
+static const pio_program_t c1351_pot_program;
+
+static inline void c1351_pot_program_init(PIO pio, uint sm, uint offset, uint pin) {}
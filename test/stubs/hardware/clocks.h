@@ -0,0 +1,10 @@
+#pragma once
+#include <stdint.h>
+
+#define clk_sys  0
+
+extern uint32_t test_clk_sys_hz;
+
+static inline uint32_t clock_get_hz(int clk) {
+  return test_clk_sys_hz;
+}
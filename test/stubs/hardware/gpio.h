@@ -0,0 +1,17 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GPIO_IN   false
+#define GPIO_OUT  true
+
+extern bool test_gpio[30];          // input levels, all high unless the test says
+
+static inline bool gpio_get(uint pin) {
+  return test_gpio[pin];
+}
+
+static inline void gpio_init(uint pin) {}
+static inline void gpio_put(uint pin, bool value) {}
+static inline void gpio_set_dir(uint pin, bool out) {}
+static inline void gpio_pull_up(uint pin) {}
@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+
+// two blocks of four state machines, the FIFOs are queues the test
+// fills (RX) and empties (TX)
+#define TEST_FIFO  64
+
+typedef int PIO;
+
+#define pio0  0
+#define pio1  1
+
+typedef struct {
+  int dummy;
+} pio_program_t;
+
+typedef struct {
+  uint32_t data[TEST_FIFO];
+  int      head, count;
+} TestFifo;
+
+extern TestFifo test_rx[2][4], test_tx[2][4];
+extern int      test_tx_depth;      // TX FIFO entries the state machine takes
+
+static inline void test_fifo_put(TestFifo *f, uint32_t v) {
+  if (f->count < TEST_FIFO)
+    f->data[(f->head + f->count++) % TEST_FIFO] = v;
+}
+
+static inline uint32_t test_fifo_get(TestFifo *f) {
+  uint32_t v = f->data[f->head];
+
+  f->head = (f->head + 1) % TEST_FIFO;
+  f->count--;
+  return v;
+}
+
+static inline uint pio_get_index(PIO pio) {
+  return pio;
+}
+
+static inline void pio_sm_claim(PIO pio, uint sm) {}
+
+static inline int pio_claim_unused_sm(PIO pio, bool required) {
+  static int next[2];
+
+  return next[pio]++ & 3;
+}
+
+static inline uint pio_add_program(PIO pio, const pio_program_t *program) {
+  return 0;
+}
+
+static inline void pio_sm_set_clkdiv(PIO pio, uint sm, float div) {}
+
+static inline bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) {
+  return test_rx[pio][sm].count == 0;
+}
+
+static inline uint32_t pio_sm_get(PIO pio, uint sm) {
+  return test_fifo_get(&test_rx[pio][sm]);
+}
+
+static inline bool pio_sm_is_tx_fifo_full(PIO pio, uint sm) {
+  return test_tx[pio][sm].count >= test_tx_depth;
+}
+
+static inline bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm) {
+  return test_tx[pio][sm].count == 0;
+}
+
+static inline void pio_sm_put(PIO pio, uint sm, uint32_t v) {
+  test_fifo_put(&test_tx[pio][sm], v);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <stdint.h>
+
+// the interrupt endpoint registers of the host controller, in memory
+#define USB_HOST_INTERRUPT_ENDPOINTS         15
+#define USB_ADDR_ENDP1_ADDRESS_BITS          0x0000007f
+#define USB_ADDR_ENDP1_ENDPOINT_LSB          16
+#define USB_ADDR_ENDP1_INTEP_DIR_BITS        0x02000000
+#define EP_CTRL_ENABLE_BITS                  0x80000000
+#define EP_CTRL_HOST_INTERRUPT_INTERVAL_LSB  16
+
+typedef struct {
+  volatile uint32_t int_ep_addr_ctrl[USB_HOST_INTERRUPT_ENDPOINTS];
+} usb_hw_t;
+
+typedef struct {
+  struct {
+    volatile uint32_t ctrl;
+    volatile uint32_t spare;
+  } int_ep_ctrl[USB_HOST_INTERRUPT_ENDPOINTS];
+} usb_host_dpram_t;
+
+extern usb_hw_t         test_usb_hw;
+extern usb_host_dpram_t test_usbh_dpram;
+
+#define usb_hw      (&test_usb_hw)
+#define usbh_dpram  (&test_usbh_dpram)
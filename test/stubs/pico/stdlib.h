@@ -0,0 +1,20 @@
+#pragma once
+// host build: just enough of the Pico SDK for the code under test
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+
+#define __not_in_flash_func(f) f
+
+extern uint64_t test_now_us;        // the clock, moved by the test
+
+static inline uint64_t time_us_64(void) {
+  return test_now_us;
+}
+
+static inline uint32_t time_us_32(void) {
+  return (uint32_t) test_now_us;
+}
@@ -0,0 +1,5 @@
+static const pio_program_t ps2_device_program;
+static const pio_program_t xt_device_program;
+
+static inline void ps2_device_program_init(PIO pio, uint sm, uint offset, uint pin) {}
+static inline void xt_device_program_init(PIO pio, uint sm, uint offset, uint pin) {}
@@ -0,0 +1,16 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// host tests: a failed check is printed and counted, main() returns
+// the count so ctest sees it
+extern int test_failed;
+
+#define CHECK(cond, ...) do {						\
+    if (!(cond)) {							\
+      printf("%s:%d: %s: ", __FILE__, __LINE__, #cond);		\
+      printf(__VA_ARGS__);						\
+      printf("\n");							\
+      test_failed++;							\
+    }									\
+  } while (0)
@@ -0,0 +1,70 @@
+#include <math.h>
+#include "test.h"
+#include "../c1351.c"
+
+// phi2 cycles of a state machine count
+static double phi2(uint32_t cycles) {
+  return (double) cycles * phi2_hz / sm_hz;
+}
+
+// the SID sees the line rise 256 + value cycles into the window, value
+// 64..190 from bits 0..5 of the position, and it is let go again about
+// C1351_RELEASE, well before the discharge at 512
+static void test_pot_words(uint32_t clk, bool ntsc) {
+  uint32_t word, last = 0;
+  double rise, release;
+  int p;
+
+  test_clk_sys_hz = clk;
+  c1351_init(ntsc);
+  for (p = 0; p < 256; p++) {
+    uint32_t value = 64 + ((p & 0x3F) << 1);
+
+    word    = pot_word(p);
+    rise    = phi2((word & 0xFFFF) + C1351_LATENCY);
+    release = rise + phi2(word >> 16);
+    CHECK(fabs(rise - (256 + value)) <= 0.5, "%u Hz %s, position %d: rises at %.2f, expected %u",
+	  clk, ntsc ? "NTSC" : "PAL", p, rise, 256 + value);
+    CHECK((release > C1351_RELEASE - 1) && (release < C1351_RELEASE + 1),
+	  "%u Hz %s, position %d: released at %.2f", clk, ntsc ? "NTSC" : "PAL", p, release);
+    CHECK(((word & 0xFFFF) + C1351_LATENCY) * (uint64_t) phi2_hz / sm_hz < 512, "position %d: past the window", p);
+    CHECK(word == pot_word(p & 0x3F), "position %d: not modulo 64", p);
+    if (p & 0x3F)
+      CHECK((word & 0xFFFF) > (last & 0xFFFF), "position %d: not after position %d", p, p - 1);
+    last = word;
+  }
+}
+
+// X follows the mouse, Y grows away from the user, and a new word only
+// goes once the previous one is taken
+static void test_move(void) {
+  test_clk_sys_hz = 125000000;
+  c1351_init(false);
+  test_tx[C1351_PIO][sm[0]].count = 0;
+  test_tx[C1351_PIO][sm[1]].count = 0;
+  c1351_move(5, 1, false, false);
+  c1351_task();
+  CHECK(test_tx[C1351_PIO][sm[0]].count == 1, "X word not sent");
+  CHECK(test_fifo_get(&test_tx[C1351_PIO][sm[0]]) == pot_word(5), "X word is not position 5");
+  CHECK(test_tx[C1351_PIO][sm[1]].count == 1, "Y word not sent");
+  CHECK(test_fifo_get(&test_tx[C1351_PIO][sm[1]]) == pot_word(63), "Y word is not position 63");
+  c1351_move(1, 0, false, false);
+  c1351_task();
+  c1351_move(1, 0, false, false);
+  c1351_task();
+  CHECK(test_tx[C1351_PIO][sm[0]].count == 1, "%d X words queued", test_tx[C1351_PIO][sm[0]].count);
+  test_fifo_get(&test_tx[C1351_PIO][sm[0]]);
+  c1351_task();
+  CHECK(test_fifo_get(&test_tx[C1351_PIO][sm[0]]) == pot_word(7), "X word is not the latest position");
+}
+
+int main(void) {
+  test_pot_words(125000000, false);
+  test_pot_words(125000000, true);
+  test_pot_words(133000000, false);
+  test_pot_words(133000000, true);
+  test_move();
+  if (test_failed)
+    printf("%d checks failed\n", test_failed);
+  return test_failed ? 1 : 0;
+}
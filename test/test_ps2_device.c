@@ -0,0 +1,82 @@
+#include "test.h"
+#include "../ps2_device.c"
+
+#define SM  1
+#define TX  test_tx[0][SM]
+#define RX  test_rx[0][SM]
+
+static Ps2Device dev;
+
+static int parity(uint8_t data) {
+  int i, n = 0;
+
+  for (i = 0; i < 8; i++)
+    n += (data >> i) & 1;
+  return n & 1;
+}
+
+// a frame as the host clocks it in: start 0, data, odd parity, stop 1
+static uint32_t host_frame(uint8_t data) {
+  return ((uint32_t) data << 1) | ((parity(data) ? 0 : 1) << 9) | 0x400;
+}
+
+static void test_frames(void) {
+  uint32_t f;
+  int d;
+
+  for (d = 0; d < 256; d++) {
+    f = ~ps2_frame(d, false) & 0x7FF;
+    CHECK(!(f & 0x001), "AT %02x: start bit", d);
+    CHECK(((f >> 1) & 0xFF) == d, "AT %02x: data %02x", d, (f >> 1) & 0xFF);
+    CHECK(parity(d) ^ ((f >> 9) & 1), "AT %02x: parity not odd", d);
+    CHECK(f & 0x400, "AT %02x: stop bit", d);
+    CHECK(!(ps2_frame(d, false) & ~0x7FFu), "AT %02x: bits above the stop bit", d);
+    f = ~ps2_frame(d, true) & 0x1FF;
+    CHECK(f & 0x001, "XT %02x: start bit", d);
+    CHECK(((f >> 1) & 0xFF) == d, "XT %02x: data %02x", d, (f >> 1) & 0xFF);
+    CHECK(!(ps2_frame(d, true) & ~0x1FFu), "XT %02x: bits above the data", d);
+  }
+}
+
+// the host aborts a frame to send a command: the aborted byte must
+// not go out before the answer. with no command it goes out again
+static void test_abort(void) {
+  ps2_device_init(&dev, pio0, SM, 4, false);
+  ps2_device_send(&dev, 0x1C);
+  ps2_device_send(&dev, 0x32);
+  CHECK(ps2_device_task(&dev) == PS2_RX_NONE, "host byte out of nowhere");
+  CHECK(TX.count == 1, "%d frames handed over, expected 1", TX.count);
+  test_fifo_get(&TX);
+  test_fifo_put(&RX, PS2_FRAME_ABORT);
+  test_fifo_put(&RX, host_frame(0xEE));
+  CHECK(ps2_device_task(&dev) == 0xEE, "host byte not returned");
+  CHECK(TX.count == 0, "frame handed over with the host byte");
+  CHECK((dev.size == 1) && (dev.data[dev.head] == 0x32), "aborted byte still queued");
+
+  ps2_device_flush(&dev);
+  ps2_device_send(&dev, 0x1C);
+  ps2_device_task(&dev);
+  test_fifo_get(&TX);
+  test_fifo_put(&RX, PS2_FRAME_ABORT);
+  CHECK(ps2_device_task(&dev) == PS2_RX_NONE, "host byte out of nowhere");
+  CHECK(TX.count == 0, "aborted frame resent at once");
+  test_gpio[4 + 1] = false;
+  test_now_us += PS2_ABORT_HOLD_US;
+  ps2_device_task(&dev);
+  CHECK(TX.count == 0, "aborted frame resent while CLK is low");
+  test_gpio[4 + 1] = true;
+  test_now_us += PS2_ABORT_HOLD_US / 2;
+  ps2_device_task(&dev);
+  CHECK(TX.count == 0, "aborted frame resent within the hold");
+  test_now_us += PS2_ABORT_HOLD_US;
+  ps2_device_task(&dev);
+  CHECK((TX.count == 1) && (((~test_fifo_get(&TX) >> 1) & 0xFF) == 0x1C), "aborted frame not resent");
+}
+
+int main(void) {
+  test_frames();
+  test_abort();
+  if (test_failed)
+    printf("%d checks failed\n", test_failed);
+  return test_failed ? 1 : 0;
+}
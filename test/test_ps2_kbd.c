@@ -0,0 +1,115 @@
+#include "test.h"
+#include "../ps2_kbd.c"
+
+bool debug            = false;
+bool capslock_state   = false;
+bool numlock_state    = true;
+bool scrolllock_state = false;
+
+#define TX  test_tx[PS2_KBD_PIO][PS2_KBD_SM]
+#define RX  test_rx[PS2_KBD_PIO][PS2_KBD_SM]
+
+static int parity(uint8_t data) {
+  int i, n = 0;
+
+  for (i = 0; i < 8; i++)
+    n += (data >> i) & 1;
+  return n & 1;
+}
+
+// a frame as the host clocks it in: start 0, data, odd parity, stop 1
+static uint32_t host_frame(uint8_t data) {
+  return ((uint32_t) data << 1) | ((parity(data) ? 0 : 1) << 9) | 0x400;
+}
+
+// what went on the wire since the last call, every frame completes
+static int wire(uint8_t *out, int max) {
+  int n = 0, idle;
+
+  for (idle = 0; idle < 4; idle++) {
+    ps2_kbd_task();
+    while (TX.count && (n < max)) {
+      out[n++] = (~test_fifo_get(&TX) >> 1) & 0xFF;
+      test_fifo_put(&RX, PS2_FRAME_DONE);
+      idle = 0;
+    }
+  }
+  return n;
+}
+
+static void want(const char *what, const uint8_t *bytes, int nbytes) {
+  uint8_t got[32];
+  int n = wire(got, sizeof(got)), i;
+
+  CHECK(n == nbytes, "%s: %d bytes, expected %d", what, n, nbytes);
+  for (i = 0; (i < n) && (i < nbytes); i++)
+    CHECK(got[i] == bytes[i], "%s: byte %d is %02x, expected %02x", what, i, got[i], bytes[i]);
+}
+
+static void host(uint8_t data) {
+  test_fifo_put(&RX, host_frame(data));
+}
+
+// both sets cover the same keys, set 1 make codes leave bit 7 for the
+// break, no code is a prefix byte and only \ / non-US # share one
+static void test_tables(void) {
+  static const uint8_t prefix[] = { 0xE0, 0xE1, 0xF0, 0xFA, 0xFE, 0xAA, 0xEE, 0x00 };
+  int i, j, k;
+
+  for (i = 0; i < 0x74; i++) {
+    CHECK(!to_set1[i] == !to_set2[i], "usage %02x: in one set only", i);
+    CHECK(!(to_set1[i] & 0x80), "usage %02x: set 1 make %03x has the break bit", i, to_set1[i]);
+    for (k = 0; to_set2[i] && (k < sizeof(prefix)); k++) {
+      CHECK((to_set2[i] & 0xFF) != prefix[k], "usage %02x: set 2 code %03x", i, to_set2[i]);
+      CHECK((to_set1[i] & 0xFF) != prefix[k], "usage %02x: set 1 code %03x", i, to_set1[i]);
+    }
+    for (j = i + 1; to_set2[i] && (j < 0x74); j++)
+      if (!((i == 0x31) && (j == 0x32))) {
+	CHECK(to_set2[i] != to_set2[j], "usages %02x and %02x: set 2 code %03x", i, j, to_set2[i]);
+	CHECK(to_set1[i] != to_set1[j], "usages %02x and %02x: set 1 code %03x", i, j, to_set1[i]);
+      }
+  }
+  for (i = 0; i < 8; i++) {
+    CHECK(mod_set2[i] && mod_set1[i], "modifier %d: missing", i);
+    CHECK(!(mod_set1[i] & 0x80), "modifier %d: set 1 make has the break bit", i);
+  }
+  for (i = 0; i < KBD_MEDIA_KEYS; i++) {
+    CHECK((media_set2[i] & PS2_E0) && (media_set1[i] & PS2_E0), "media key %d: not extended", i);
+    CHECK(!(media_set1[i] & 0x80), "media key %d: set 1 make has the break bit", i);
+  }
+}
+
+static void test_keyboard(void) {
+  static const uint8_t bat[]       = { PS2_BAT_OK };
+  static const uint8_t a_set2[]    = { 0x1C, 0xF0, 0x1C };
+  static const uint8_t ack[]       = { PS2_ACK };
+  static const uint8_t a_set1[]    = { 0x1E, 0x9E };
+  static const uint8_t up_set1[]   = { 0xE0, 0x48, 0xE0, 0xC8 };
+
+  ps2_kbd_init(false);
+  want("self test", bat, sizeof(bat));
+  ps2_kbd_key_event(0x04, true);
+  ps2_kbd_key_event(0x04, false);
+  want("A in set 2", a_set2, sizeof(a_set2));
+
+  host(0xF0);
+  want("F0", ack, sizeof(ack));
+  host(PS2_SCAN_SET_1);
+  want("set 1", ack, sizeof(ack));
+  ps2_kbd_key_event(0x04, true);
+  ps2_kbd_key_event(0x04, false);
+  want("A in set 1", a_set1, sizeof(a_set1));
+  ps2_kbd_key_event(0x52, true);
+  ps2_kbd_key_event(0x52, false);
+  want("up in set 1", up_set1, sizeof(up_set1));
+  host(0xF6);
+  want("defaults", ack, sizeof(ack));
+}
+
+int main(void) {
+  test_tables();
+  test_keyboard();
+  if (test_failed)
+    printf("%d checks failed\n", test_failed);
+  return test_failed ? 1 : 0;
+}
@@ -0,0 +1,13 @@
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+
+int      test_failed = 0;
+uint64_t test_now_us = 1000000;
+bool     test_gpio[30] = {
+  true, true, true, true, true, true, true, true, true, true,
+  true, true, true, true, true, true, true, true, true, true,
+  true, true, true, true, true, true, true, true, true, true
+};
+TestFifo test_rx[2][4], test_tx[2][4];
+int      test_tx_depth = 4;
+uint32_t test_clk_sys_hz = 125000000;
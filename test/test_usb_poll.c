@@ -0,0 +1,71 @@
+#include "test.h"
+#include "../usb_poll.c"
+
+bool hid_debug = false;
+
+usb_hw_t         test_usb_hw;
+usb_host_dpram_t test_usbh_dpram;
+uint16_t         test_vid, test_pid;
+
+#define IN        0
+#define OUT       USB_ADDR_ENDP1_INTEP_DIR_BITS
+#define ENABLED   EP_CTRL_ENABLE_BITS
+
+static void endpoint(int i, uint8_t dev_addr, uint8_t ep, uint32_t dir, uint32_t ctrl, uint8_t interval) {
+  test_usb_hw.int_ep_addr_ctrl[i] = dir | ((uint32_t) ep << USB_ADDR_ENDP1_ENDPOINT_LSB) | dev_addr;
+  test_usbh_dpram.int_ep_ctrl[i].ctrl = ctrl | ((uint32_t) (interval - 1) << EP_CTRL_HOST_INTERRUPT_INTERVAL_LSB) | 0x0180;
+}
+
+static uint8_t interval(int i) {
+  return ((test_usbh_dpram.int_ep_ctrl[i].ctrl & INTERVAL_BITS) >> EP_CTRL_HOST_INTERRUPT_INTERVAL_LSB) + 1;
+}
+
+// only the enabled IN endpoints of that device change, and only their
+// interval bits
+static void test_set_interval(void) {
+  endpoint(0, 1, 1, IN,  ENABLED, 10);      // the pad
+  endpoint(1, 1, 2, OUT, ENABLED, 10);      // its rumble
+  endpoint(2, 2, 1, IN,  ENABLED, 8);       // another device
+  endpoint(3, 1, 3, IN,  0,       10);      // closed
+  CHECK(set_interval(1, 1) == 1, "%d endpoints rewritten", set_interval(1, 1));
+  CHECK(interval(0) == 1, "IN endpoint polled every %d ms", interval(0));
+  CHECK((test_usbh_dpram.int_ep_ctrl[0].ctrl & ~INTERVAL_BITS) == (ENABLED | 0x0180), "other control bits changed");
+  CHECK(interval(1) == 10, "OUT endpoint changed to %d ms", interval(1));
+  CHECK(interval(2) == 8, "other device changed to %d ms", interval(2));
+  CHECK(interval(3) == 10, "closed endpoint changed to %d ms", interval(3));
+}
+
+// 1 ms reports alternating 200 us early and late: min / max / mean,
+// and a jitter near the 400 us from one interval to the next. a gap
+// past USB_POLL_IDLE_US is not an interval
+static void test_window(void) {
+  UsbPollSlot *s;
+  int i;
+
+  usb_poll_report(1, 0);
+  for (i = 0; i < USB_POLL_WINDOW; i++) {
+    test_now_us += (i & 1) ? 800 : 1200;
+    usb_poll_report(1, 0);
+    if (i == 10) {
+      test_now_us += USB_POLL_IDLE_US + 1;
+      usb_poll_report(1, 0);
+    }
+  }
+  s = find_slot(1, 0);
+  CHECK(s && (s->window.reports == USB_POLL_WINDOW), "no complete window");
+  if (!s)
+    return;
+  CHECK((s->window.min_us == 800) && (s->window.max_us == 1200), "%d..%d us", s->window.min_us, s->window.max_us);
+  CHECK(s->window.mean_us == 1000, "mean %d us", s->window.mean_us);
+  CHECK((s->window.jitter_us > 350) && (s->window.jitter_us <= 400), "jitter %d us", s->window.jitter_us);
+  usb_poll_umount(1);
+  CHECK(!find_slot(1, 0), "slot kept after unmount");
+}
+
+int main(void) {
+  test_set_interval();
+  test_window();
+  if (test_failed)
+    printf("%d checks failed\n", test_failed);
+  return test_failed ? 1 : 0;
+}
@@ -4,7 +4,7 @@
 //#define CFG_TUH_CDC                 0
 //#define CFG_TUH_HID                 4
 //#define CFG_TUH_MSC                 1
-//#define CFG_TUH_VENDOR              0
+//#define CFG_TUH_VENDOR              0 // XInput pads have their own driver, registered by xinput.c
 //
 //#define CFG_TUSB_HOST_DEVICE_MAX    (CFG_TUH_HUB ? 5 : 1) // normal hub has 4 ports
 
@@ -60,14 +60,15 @@
 //--------------------------------------------------------------------
 
 // Size of buffer to hold descriptors and other data used for enumeration
-#define CFG_TUH_ENUMERATION_BUFSIZE 256
+// touchscreen report descriptors run past 256 bytes
+#define CFG_TUH_ENUMERATION_BUFSIZE 512
 
 #define CFG_TUH_HUB                 1
 #define CFG_TUH_CDC                 0
 #define CFG_TUH_HID                 4 // typical keyboard + mouse device can have 3-4 HID interfaces
 #define CFG_TUH_MIDI                0 // there will be at most one MIDIStreaming Interface descriptor
 #define CFG_TUH_MSC                 0
-#define CFG_TUH_VENDOR              0
+#define CFG_TUH_VENDOR              0 // XInput pads have their own driver, registered by xinput.c
 
 // max device support (excluding hub device)
 #define CFG_TUH_DEVICE_MAX          (CFG_TUH_HUB ? 5 : 1) // hub typically has 4 ports
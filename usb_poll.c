@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/structs/usb.h"
+#include "tusb.h"
+#include "usb_poll.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+#define INTERVAL_BITS  (0x3FFu << EP_CTRL_HOST_INTERRUPT_INTERVAL_LSB)
+
+extern bool hid_debug;
+
+// devices known to answer faster than their bInterval says. a device
+// that does not keep up NAKs or repeats its last report; measure with
+// hid_debug before adding one
+const UsbPollQuirk usb_poll_quirks[] = {
+  // { 0x081f, 0xe401, 1 },
+  { 0, 0, 0 }
+};
+
+static UsbPollSlot slots[USB_POLL_SLOTS];
+
+static UsbPollSlot *find_slot(uint8_t dev_addr, uint8_t itf) {
+  int i;
+
+  for (i = 0; i < USB_POLL_SLOTS; i++)
+    if ((slots[i].dev_addr == dev_addr) && (!dev_addr || (slots[i].itf == itf)))
+      return &slots[i];
+  return NULL;
+}
+
+// the host controller polls the interrupt endpoints on its own, from
+// the interval in their control word: rewrite it for the IN endpoints
+// the device has open so far
+static int set_interval(uint8_t dev_addr, uint8_t interval) {
+  uint32_t addr, ctrl;
+  int i, n = 0;
+
+  for (i = 0; i < USB_HOST_INTERRUPT_ENDPOINTS; i++) {
+    addr = usb_hw->int_ep_addr_ctrl[i];
+    ctrl = usbh_dpram->int_ep_ctrl[i].ctrl;
+    // the direction bit is set for OUT endpoints (rumble, LEDs)
+    if (((addr & USB_ADDR_ENDP1_ADDRESS_BITS) != dev_addr) || (addr & USB_ADDR_ENDP1_INTEP_DIR_BITS) ||
+	!(ctrl & EP_CTRL_ENABLE_BITS))
+      continue;
+    usbh_dpram->int_ep_ctrl[i].ctrl = (ctrl & ~INTERVAL_BITS) |
+      ((uint32_t) (interval - 1) << EP_CTRL_HOST_INTERRUPT_INTERVAL_LSB);
+    n++;
+  }
+  return n;
+}
+
+// once per interface: the endpoints of the device are opened one
+// interface after the other
+void usb_poll_mount(uint8_t dev_addr) {
+  const UsbPollQuirk *q;
+  uint16_t vid, pid;
+
+  tuh_vid_pid_get(dev_addr, &vid, &pid);
+  for (q = usb_poll_quirks; q->interval; q++)
+    if ((q->vid == vid) && (q->pid == pid)) {
+      if ((set_interval(dev_addr, q->interval) > 0) && hid_debug)
+	printf("%0.4x %0.4x polled every %d ms\n", vid, pid, q->interval);
+      return;
+    }
+}
+
+// the time between reports of an interface. they are taken when the
+// callback runs, so the main loop adds its own latency to the figures
+void usb_poll_report(uint8_t dev_addr, uint8_t itf) {
+  UsbPollSlot *s = find_slot(dev_addr, itf);
+  uint32_t now = time_us_32(), interval, delta;
+
+  if (!s) {
+    if (!(s = find_slot(0, 0)))
+      return;
+    memset(s, 0, sizeof(*s));
+    s->dev_addr = dev_addr;
+    s->itf      = itf;
+    s->last_us  = now;
+    return;
+  }
+  interval   = now - s->last_us;
+  s->last_us = now;
+  if (interval > USB_POLL_IDLE_US) {
+    s->last_interval = 0;
+    return;
+  }
+  if (s->last_interval) {
+    delta = (interval > s->last_interval) ? interval - s->last_interval : s->last_interval - interval;
+    s->jitter += delta - ((s->jitter + 8) >> 4);
+  }
+  s->last_interval = interval;
+  if (!s->n || (interval < s->min_us))
+    s->min_us = interval;
+  if (interval > s->max_us)
+    s->max_us = interval;
+  s->sum_us += interval;
+  if (++s->n < USB_POLL_WINDOW)
+    return;
+  s->window.reports   = s->n;
+  s->window.min_us    = s->min_us;
+  s->window.mean_us   = s->sum_us / s->n;
+  s->window.max_us    = s->max_us;
+  s->window.jitter_us = (s->jitter + 8) >> 4;
+  if (hid_debug)
+    printf("device %d itf %d: %d reports, interval %d / %d / %d us, jitter %d us\n", dev_addr, itf,
+	   s->window.reports, s->window.min_us, s->window.mean_us, s->window.max_us, s->window.jitter_us);
+  s->n      = 0;
+  s->max_us = 0;
+  s->sum_us = 0;
+}
+
+void usb_poll_umount(uint8_t dev_addr) {
+  int i;
+
+  for (i = 0; i < USB_POLL_SLOTS; i++)
+    if (slots[i].dev_addr == dev_addr)
+      memset(&slots[i], 0, sizeof(slots[i]));
+}
@@ -0,0 +1,35 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#define USB_POLL_SLOTS    8         // interfaces measured at once
+#define USB_POLL_WINDOW   1000      // intervals per statistics window
+#define USB_POLL_IDLE_US  50000     // longer gaps: the device had nothing to send
+
+// polling interval forced on the interrupt IN endpoints of a device
+typedef struct {
+  uint16_t vid, pid;
+  uint8_t  interval;                // ms, 1..255
+} UsbPollQuirk;
+
+typedef struct {
+  uint32_t reports;                 // intervals in the window
+  uint32_t min_us, mean_us, max_us;
+  uint32_t jitter_us;               // mean change from one interval to the next
+} UsbPollStats;
+
+typedef struct {
+  uint8_t      dev_addr;            // 0 = free
+  uint8_t      itf;
+  uint32_t     last_us;
+  uint32_t     last_interval;
+  uint32_t     jitter;              // us, Q4
+  uint32_t     n, min_us, max_us;
+  uint64_t     sum_us;
+  UsbPollStats window;              // the last complete window
+} UsbPollSlot;
+
+extern const UsbPollQuirk usb_poll_quirks[];
+
+void usb_poll_mount(uint8_t);
+void usb_poll_report(uint8_t, uint8_t);
+void usb_poll_umount(uint8_t);
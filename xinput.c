@@ -0,0 +1,315 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "host/usbh_pvt.h"
+#include "gamepad.h"
+#include "gamepad_state.h"
+#include "autofire.h"
+#include "xinput.h"
+#include "usb_poll.h"
+
+#define HOTSPOT __inline__ __attribute__ ((always_inline, hot))
+
+extern void process_gamepad(uint8_t, const GamepadState *);
+extern void process_gamepad_mount(uint8_t, uint16_t, uint16_t);
+extern bool hid_debug;
+
+typedef struct {
+  uint8_t dev_addr;                 // 0 = free
+  uint8_t itf_num;
+  uint8_t ep_in;
+  uint8_t ep_out;
+  bool    wireless;
+  bool    connected;                // wireless: a pad is paired on this slot
+  bool    out_pending;              // out holds a report waiting for the endpoint
+  uint8_t player;
+  uint8_t last[12];                 // report bytes 2..13 last published
+  TU_ATTR_ALIGNED(4) uint8_t in[32];
+  TU_ATTR_ALIGNED(4) uint8_t out[12];
+} XinputSlot;
+
+static XinputSlot slots[XINPUT_SLOTS];
+static uint8_t    players_used;
+
+// report bits 0..15 to GAMEPAD_*, the d-pad (bits 0..3) is the hat
+static const uint16_t button_map[16] = {
+  0, 0, 0, 0,
+  GAMEPAD_START, GAMEPAD_SELECT, GAMEPAD_L3, GAMEPAD_R3,
+  GAMEPAD_LEFT, GAMEPAD_RIGHT, GAMEPAD_HOME, 0,
+  GAMEPAD_A, GAMEPAD_B, GAMEPAD_X, GAMEPAD_Y
+};
+
+// up 1, down 2, left 4, right 8 to 0 centered, 1 up clockwise to 8
+static const uint8_t dpad_hat[16] = {
+  0, 1, 5, 0, 7, 8, 6, 7, 3, 2, 4, 3, 0, 1, 5, 0
+};
+
+static XinputSlot *find_slot(uint8_t dev_addr, uint8_t ep_addr) {
+  int i;
+
+  for (i = 0; i < XINPUT_SLOTS; i++)
+    if ((slots[i].dev_addr == dev_addr) && ((slots[i].ep_in == ep_addr) || (slots[i].ep_out == ep_addr)))
+      return &slots[i];
+  return NULL;
+}
+
+// the deadzone is cut out and the rest spread over the full range
+HOTSPOT static int16_t axis_value(int32_t v, int32_t deadzone, bool invert) {
+  if (abs(v) <= deadzone)
+    return 0;
+  v = (v > 0) ? v - deadzone : v + deadzone;
+  v = v * GAMEPAD_AXIS_MAX / (32768 - deadzone);
+  if (v > GAMEPAD_AXIS_MAX)
+    v = GAMEPAD_AXIS_MAX;
+  if (v < -GAMEPAD_AXIS_MAX)
+    v = -GAMEPAD_AXIS_MAX;
+  return invert ? -v : v;
+}
+
+static void send_out(XinputSlot *s) {
+  if (!s->ep_out)
+    return;
+  if (!usbh_edpt_claim(s->dev_addr, s->ep_out)) {
+    s->out_pending = true;
+    return;
+  }
+  s->out_pending = false;
+  if (!usbh_edpt_xfer(s->dev_addr, s->ep_out, s->out, s->wireless ? 12 : s->out[1]))
+    usbh_edpt_release(s->dev_addr, s->ep_out);
+}
+
+// player n lit on the ring of the pad
+static void set_led(XinputSlot *s) {
+  uint8_t pattern = 0x06 + s->player;
+
+  memset(s->out, 0, sizeof(s->out));
+  if (s->wireless) {
+    s->out[2] = 0x08;
+    s->out[3] = 0x40 | pattern;
+  } else {
+    s->out[0] = 0x01;
+    s->out[1] = 0x03;
+    s->out[2] = pattern;
+  }
+  send_out(s);
+}
+
+void xinput_rumble(uint8_t player, uint8_t big, uint8_t small) {
+  int i;
+
+  for (i = 0; i < XINPUT_SLOTS; i++) {
+    XinputSlot *s = &slots[i];
+
+    if (!s->dev_addr || !s->connected || (s->player != player))
+      continue;
+    memset(s->out, 0, sizeof(s->out));
+    if (s->wireless) {
+      s->out[1] = 0x01;
+      s->out[2] = 0x0F;
+      s->out[3] = 0xC0;
+      s->out[5] = big;
+      s->out[6] = small;
+    } else {
+      s->out[1] = 0x08;
+      s->out[3] = big;
+      s->out[4] = small;
+    }
+    send_out(s);
+  }
+}
+
+static void connect(XinputSlot *s) {
+  uint16_t vid, pid;
+  int i;
+
+  s->connected = true;
+  s->player    = XINPUT_NO_PLAYER;
+  memset(s->last, 0xFF, sizeof(s->last));
+  for (i = 0; i < GAMEPAD_PLAYERS; i++)
+    if (!(players_used & (1 << i))) {
+      players_used |= 1 << i;
+      s->player = i;
+      break;
+    }
+  tuh_vid_pid_get(s->dev_addr, &vid, &pid);
+  if (hid_debug)
+    printf("xinput %0.4x %0.4x connected, player %d\n", vid, pid, s->player);
+  if (s->player == XINPUT_NO_PLAYER)
+    return;
+  set_led(s);
+  process_gamepad_mount(s->player, vid, pid);
+}
+
+static void disconnect(XinputSlot *s) {
+  GamepadState idle = { { 0 } };
+
+  if (s->connected && (s->player != XINPUT_NO_PLAYER)) {
+    // nothing held down on the outputs once the pad is gone
+    autofire_publish(s->player, &idle);
+    process_gamepad(s->player, &idle);
+    players_used &= ~(1 << s->player);
+    if (hid_debug)
+      printf("xinput player %d disconnected\n", s->player);
+  }
+  s->connected = false;
+  s->player    = XINPUT_NO_PLAYER;
+}
+
+// the 20 byte input report, same layout wired and behind the receiver
+static void decode(XinputSlot *s, const uint8_t *r) {
+  GamepadState state;
+  uint16_t bits;
+
+  if ((s->player == XINPUT_NO_PLAYER) || !memcmp(r + 2, s->last, sizeof(s->last)))
+    return;
+  memcpy(s->last, r + 2, sizeof(s->last));
+  bits = r[2] | (r[3] << 8);
+  state.hat     = dpad_hat[bits & 0x0F];
+  state.buttons = 0;
+  for (bits &= 0xFFF0; bits; bits &= bits - 1)
+    state.buttons |= button_map[__builtin_ctz(bits)];
+  if (r[4] > XINPUT_TRIGGER)
+    state.buttons |= GAMEPAD_L2;
+  if (r[5] > XINPUT_TRIGGER)
+    state.buttons |= GAMEPAD_R2;
+  // XInput Y grows upwards, the register's downwards
+  state.axis[0] = axis_value((int16_t) (r[6] | (r[7] << 8)), XINPUT_DEADZONE_L, false);
+  state.axis[1] = axis_value((int16_t) (r[8] | (r[9] << 8)), XINPUT_DEADZONE_L, true);
+  state.axis[2] = axis_value((int16_t) (r[10] | (r[11] << 8)), XINPUT_DEADZONE_R, false);
+  state.axis[3] = axis_value((int16_t) (r[12] | (r[13] << 8)), XINPUT_DEADZONE_R, true);
+  autofire_publish(s->player, &state);
+  process_gamepad(s->player, &state);
+}
+
+static void report(XinputSlot *s, const uint8_t *r, uint32_t len) {
+  if (!s->wireless) {
+    if ((len >= 14) && (r[0] == 0x00) && (r[1] >= 14))
+      decode(s, r);
+    return;
+  }
+  // receiver: 08 xx is the link status of the slot, 00 01 carries input
+  if ((len >= 2) && (r[0] == 0x08)) {
+    if ((r[1] & 0x80) && !s->connected)
+      connect(s);
+    else if (!(r[1] & 0x80) && s->connected)
+      disconnect(s);
+  } else if ((len >= 18) && s->connected && (r[0] == 0x00) && (r[1] == 0x01) && (r[5] >= 0x13))
+    decode(s, r + 4);
+}
+
+static bool xinput_init(void) {
+  memset(slots, 0, sizeof(slots));
+  players_used = 0;
+  return true;
+}
+
+static bool xinput_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_interface_t const *itf, uint16_t max_len) {
+  uint8_t const *p   = (uint8_t const *) itf;
+  uint8_t const *end = p + max_len;
+  XinputSlot *s = NULL;
+  int i, found = 0;
+
+  if ((itf->bInterfaceClass != TUSB_CLASS_VENDOR_SPECIFIC) || (itf->bInterfaceSubClass != XINPUT_SUBCLASS) ||
+      ((itf->bInterfaceProtocol != XINPUT_WIRED) && (itf->bInterfaceProtocol != XINPUT_WIRELESS)))
+    return false;
+  for (i = 0; i < XINPUT_SLOTS; i++)
+    if (!slots[i].dev_addr) {
+      s = &slots[i];
+      break;
+    }
+  if (!s) {
+    printf("no xinput slot left\n");
+    return false;
+  }
+  memset(s, 0, sizeof(*s));
+  s->itf_num  = itf->bInterfaceNumber;
+  s->wireless = (itf->bInterfaceProtocol == XINPUT_WIRELESS);
+  s->player   = XINPUT_NO_PLAYER;
+  // a vendor descriptor sits between the interface and its endpoints
+  for (p = tu_desc_next(p); (p < end) && (found < itf->bNumEndpoints); p = tu_desc_next(p)) {
+    tusb_desc_endpoint_t const *ep = (tusb_desc_endpoint_t const *) p;
+
+    if ((tu_desc_type(p) != TUSB_DESC_ENDPOINT) || (ep->bmAttributes.xfer != TUSB_XFER_INTERRUPT))
+      continue;
+    if (!tuh_edpt_open(dev_addr, ep))
+      return false;
+    if (tu_edpt_dir(ep->bEndpointAddress) == TUSB_DIR_IN)
+      s->ep_in = ep->bEndpointAddress;
+    else
+      s->ep_out = ep->bEndpointAddress;
+    found++;
+  }
+  if (!s->ep_in)
+    return false;
+  s->dev_addr = dev_addr;
+  return true;
+}
+
+static bool xinput_set_config(uint8_t dev_addr, uint8_t itf_num) {
+  XinputSlot *s = NULL;
+  int i;
+
+  for (i = 0; i < XINPUT_SLOTS; i++)
+    if ((slots[i].dev_addr == dev_addr) && (slots[i].itf_num == itf_num))
+      s = &slots[i];
+  if (s) {
+    if (s->wireless) {
+      // ask the receiver for the link status of the slot
+      memset(s->out, 0, sizeof(s->out));
+      s->out[0] = 0x08;
+      s->out[2] = 0x0F;
+      s->out[3] = 0xC0;
+      send_out(s);
+    } else
+      connect(s);
+    usb_poll_mount(dev_addr);
+    usbh_edpt_xfer(dev_addr, s->ep_in, s->in, sizeof(s->in));
+  }
+  usbh_driver_set_config_complete(dev_addr, itf_num);
+  return true;
+}
+
+static bool xinput_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+  XinputSlot *s = find_slot(dev_addr, ep_addr);
+
+  if (!s)
+    return false;
+  if (ep_addr == s->ep_out) {
+    if (s->out_pending)
+      send_out(s);
+    return true;
+  }
+  if (result == XFER_RESULT_SUCCESS) {
+    usb_poll_report(dev_addr, s->itf_num);
+    report(s, s->in, xferred_bytes);
+  }
+  usbh_edpt_xfer(dev_addr, s->ep_in, s->in, sizeof(s->in));
+  return true;
+}
+
+static void xinput_close(uint8_t dev_addr) {
+  int i;
+
+  usb_poll_umount(dev_addr);
+  for (i = 0; i < XINPUT_SLOTS; i++)
+    if (slots[i].dev_addr == dev_addr) {
+      disconnect(&slots[i]);
+      slots[i].dev_addr = 0;
+    }
+}
+
+static const usbh_class_driver_t xinput_driver = {
+  .init       = xinput_init,
+  .open       = xinput_open,
+  .set_config = xinput_set_config,
+  .xfer_cb    = xinput_xfer_cb,
+  .close      = xinput_close
+};
+
+// TinyUSB asks for the drivers of the application next to its own
+usbh_class_driver_t const *usbh_app_driver_get_cb(uint8_t *driver_count) {
+  *driver_count = 1;
+  return &xinput_driver;
+}
@@ -0,0 +1,13 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#define XINPUT_SUBCLASS      0x5D
+#define XINPUT_WIRED         0x01   // interface protocol of a wired 360 pad
+#define XINPUT_WIRELESS      0x81   // one per pad slot of the wireless receiver
+#define XINPUT_SLOTS         4
+#define XINPUT_NO_PLAYER     0xFF
+#define XINPUT_TRIGGER       0x30   // L2 / R2 pressed past this
+#define XINPUT_DEADZONE_L    7849   // the values Microsoft recommends
+#define XINPUT_DEADZONE_R    8689
+
+void xinput_rumble(uint8_t, uint8_t, uint8_t);